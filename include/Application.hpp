@@ -8,7 +8,9 @@
 #include <vtkRenderer.h>
 #include <memory>
 
+#include "MeshLoader.hpp"
 #include "MouseInteractorStylePP.hpp"
+#include "SessionLog.hpp"
 #include "Tools.hpp"
 
 class Application {
@@ -24,13 +26,20 @@ class Application {
 
    private:
     void mainWindow();
+    void loadingSection();
+    void addLoadedMeshes();
+    void toggleRecording();
+    void saveSelectedMesh();
     bool m_running = false;
     bool m_picking = false;
+    bool m_reorderOnLoad = false;
     vtkNew<vtkRenderer> m_renderer;
     vtkNew<vtkImGuiSDL2OpenGLRenderWindow> m_renWin;
     vtkNew<vtkImGuiSDL2RenderWindowInteractor> m_iren;
     vtkNew<vtkInteractorStyleSwitch> m_defaultStyle;
     vtkNew<MouseInteractorStylePP> m_pickingStyle;
+    SessionRecorder m_recorder;
+    MeshLoader m_loader;
     std::unique_ptr<Tools> m_tools = nullptr;
     SDL_Window* m_window = nullptr;
     SDL_GLContext m_imguiContext = nullptr;
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <vtkPolyData.h>
+#include <vtkSmartPointer.h>
+#include <vtkType.h>
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "ThreadPool.hpp"
+
+/**
+ * Runs the same operation on several meshes concurrently, one mesh per worker.
+ * Each operation works on a copy of its mesh, made on the main thread when a worker is free to start the job, so that
+ * at most one copy per worker is alive. The copy replaces the mesh on the main thread with applyFinished(), which also
+ * starts the next jobs, the meshes must not be modified until then.
+ */
+class BatchRunner {
+   public:
+    using Progress = std::function<void(double)>;
+    using Operation = std::function<void(vtkPolyData*, const Progress&)>;
+
+    struct Job {
+        std::string name;
+        vtkSmartPointer<vtkPolyData> target;
+        vtkSmartPointer<vtkPolyData> work;
+        vtkIdType size = 0;
+        std::atomic<double> progress = 0.0;
+        std::atomic<bool> done = false;
+        bool started = false;
+        bool applied = false;
+        double seconds = 0.0;
+        std::size_t peakBytes = 0;
+    };
+
+    explicit BatchRunner(unsigned nbThreads = std::thread::hardware_concurrency());
+
+    /**
+     * Queues the operation on every mesh, the largest meshes are scheduled first so that the total time is bounded by
+     * the largest mesh rather than by the sum of the meshes. Does nothing while a previous batch is running.
+     *
+     * @param meshes The name and the mesh of every actor to process.
+     * @param operation The operation, called from a worker thread with the copy of a mesh and a progress callback.
+     */
+    void run(const std::vector<std::pair<std::string, vtkPolyData*>>& meshes, Operation operation);
+
+    /**
+     * Replaces the meshes of the finished jobs by their results and starts the jobs waiting for a worker, must be
+     * called from the main thread between frames.
+     */
+    void applyFinished();
+
+    bool running() const;
+
+    /**
+     * @return true when the mesh is in the batch and its result was not applied yet.
+     */
+    bool processes(vtkPolyData* mesh) const;
+    unsigned concurrency() const { return m_pool.size(); }
+    const std::vector<std::unique_ptr<Job>>& jobs() const { return m_jobs; }
+
+   private:
+    /**
+     * Copies the meshes of the waiting jobs and submits them, as long as fewer jobs than workers are running.
+     */
+    void dispatch();
+
+    std::vector<std::unique_ptr<Job>> m_jobs;
+    std::shared_ptr<Operation> m_operation;
+    ThreadPool m_pool;
+};
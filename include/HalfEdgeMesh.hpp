@@ -0,0 +1,199 @@
+#pragma once
+
+#include <vtkPolyData.h>
+#include <vtkType.h>
+
+#include <memory>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+/**
+ * Array based half-edge structure built from the polygons of a vtkPolyData.
+ *
+ * The half-edges of a face are stored contiguously in the order of the connectivity array,
+ * half-edge h goes from origin(h) to origin(next(h)), so next, prev, opposite, face and
+ * vertex star queries are all O(1) lookups.
+ * The unique edges and the neighbor ranges of every vertex are extracted at the same time, by parallel radix sorts
+ * of the edge keys.
+ *
+ * Kernels are templated on the arity of the faces: a triangle or quad mesh stores its faces at a fixed stride, so
+ * the Arity versions of the traversals compute faces and corners with constant strides instead of reading offsets.
+ * Arity 0 is the generic polygon fallback.
+ */
+class HalfEdgeMesh {
+   public:
+    struct Edge {
+        vtkIdType a, b;
+    };
+
+    explicit HalfEdgeMesh(vtkPolyData* mesh);
+
+    /**
+     * Returns the topology of a mesh, it is built once and reused as long as the polygons are not modified.
+     *
+     * @param mesh The vtkPolyData mesh.
+     *
+     * @return A shared pointer to the topology of the mesh.
+     */
+    static std::shared_ptr<const HalfEdgeMesh> get(vtkPolyData* mesh);
+
+    /**
+     * @return the cached topology of the mesh if it is up to date, nullptr otherwise.
+     */
+    static std::shared_ptr<const HalfEdgeMesh> find(vtkPolyData* mesh);
+
+    /**
+     * @return the peak number of bytes needed to build the topology of the mesh.
+     */
+    static std::size_t predictBytes(vtkPolyData* mesh);
+
+    std::size_t memoryBytes() const;
+
+    /**
+     * @return the number of corners of every face, 3 or 4, or 0 when the faces are other polygons or of mixed sizes.
+     */
+    int faceArity() const { return m_faceArity; }
+
+    /**
+     * Calls fn with std::integral_constant<int, Arity> matching the faces of the mesh, so that a kernel is selected
+     * once per mesh.
+     */
+    template <typename Fn>
+    decltype(auto) dispatchArity(Fn&& fn) const {
+        switch (m_faceArity) {
+            case 3:
+                return fn(std::integral_constant<int, 3>{});
+            case 4:
+                return fn(std::integral_constant<int, 4>{});
+            default:
+                return fn(std::integral_constant<int, 0>{});
+        }
+    }
+
+    vtkIdType numberOfVertices() const { return m_starOffsets.size() - 1; }
+    vtkIdType numberOfFaces() const { return m_faceOffsets.size() - 1; }
+    vtkIdType numberOfHalfEdges() const { return m_heVertex.size(); }
+
+    vtkIdType faceSize(vtkIdType f) const { return m_faceOffsets[f + 1] - m_faceOffsets[f]; }
+    vtkIdType faceHalfEdge(vtkIdType f) const { return m_faceOffsets[f]; }
+    std::span<const vtkIdType> faceVertices(vtkIdType f) const {
+        return {m_heVertex.data() + m_faceOffsets[f], static_cast<size_t>(faceSize(f))};
+    }
+
+    vtkIdType face(vtkIdType h) const { return m_heFace[h]; }
+    vtkIdType origin(vtkIdType h) const { return m_heVertex[h]; }
+    vtkIdType target(vtkIdType h) const { return m_heVertex[next(h)]; }
+    vtkIdType next(vtkIdType h) const {
+        return h + 1 == m_faceOffsets[m_heFace[h] + 1] ? m_faceOffsets[m_heFace[h]] : h + 1;
+    }
+    vtkIdType prev(vtkIdType h) const {
+        return h == m_faceOffsets[m_heFace[h]] ? m_faceOffsets[m_heFace[h] + 1] - 1 : h - 1;
+    }
+
+    template <int Arity>
+    vtkIdType faceOf(vtkIdType h) const {
+        if constexpr (Arity > 0) {
+            return h / Arity;
+        } else {
+            return face(h);
+        }
+    }
+    template <int Arity>
+    vtkIdType nextOf(vtkIdType h) const {
+        if constexpr (Arity > 0) {
+            return h % Arity == Arity - 1 ? h - (Arity - 1) : h + 1;
+        } else {
+            return next(h);
+        }
+    }
+    template <int Arity>
+    vtkIdType prevOf(vtkIdType h) const {
+        if constexpr (Arity > 0) {
+            return h % Arity == 0 ? h + (Arity - 1) : h - 1;
+        } else {
+            return prev(h);
+        }
+    }
+    template <int Arity>
+    bool isFirstCorner(vtkIdType h) const {
+        if constexpr (Arity > 0) {
+            return h % Arity == 0;
+        } else {
+            return h == faceHalfEdge(face(h));
+        }
+    }
+
+    /**
+     * @return the half-edge going the other way on the same edge, -1 on a boundary or non-manifold edge.
+     */
+    vtkIdType opposite(vtkIdType h) const { return m_heOpposite[h]; }
+    bool isBoundary(vtkIdType h) const { return m_heOpposite[h] < 0; }
+    bool isBoundaryVertex(vtkIdType v) const;
+
+    /**
+     * @return the half-edges leaving the vertex v, one per face incident to v.
+     */
+    std::span<const vtkIdType> outgoing(vtkIdType v) const {
+        return {m_star.data() + m_starOffsets[v], static_cast<size_t>(m_starOffsets[v + 1] - m_starOffsets[v])};
+    }
+
+    /**
+     * @return the vertices sharing an edge with v, sorted by id.
+     */
+    std::span<const vtkIdType> neighbors(vtkIdType v) const {
+        return {m_neighbors.data() + m_neighborOffsets[v],
+                static_cast<size_t>(m_neighborOffsets[v + 1] - m_neighborOffsets[v])};
+    }
+
+    /**
+     * @return every edge of the mesh once, with a < b.
+     */
+    std::span<const Edge> edges() const { return m_edges; }
+
+    /**
+     * Calls fn on every other vertex of the faces incident to v, a vertex shared by several faces is visited once per
+     * face.
+     */
+    template <int Arity = 0, typename Fn>
+    void forEachFaceNeighbor(vtkIdType v, Fn&& fn) const {
+        for (auto h : outgoing(v)) {
+            if constexpr (Arity > 0) {
+                const vtkIdType* corners = m_heVertex.data() + (h - h % Arity);
+                const auto k = h % Arity;
+                for (int i = 1; i < Arity; ++i) fn(corners[(k + i) % Arity]);
+            } else {
+                for (auto n = next(h); n != h; n = next(n)) fn(m_heVertex[n]);
+            }
+        }
+    }
+
+    /**
+     * Calls fn(a, b, c) on the triangles of the face f, a fan around its first corner for quads and polygons.
+     */
+    template <int Arity = 0, typename Fn>
+    void forEachTriangle(vtkIdType f, Fn&& fn) const {
+        if constexpr (Arity > 0) {
+            const vtkIdType* corners = m_heVertex.data() + f * Arity;
+            for (int i = 1; i + 1 < Arity; ++i) fn(corners[0], corners[i], corners[i + 1]);
+        } else {
+            const vtkIdType* corners = m_heVertex.data() + m_faceOffsets[f];
+            for (vtkIdType i = 1; i + 1 < faceSize(f); ++i) fn(corners[0], corners[i], corners[i + 1]);
+        }
+    }
+
+   private:
+    template <int Arity>
+    void buildEdges(int vertexBits);
+
+    int m_faceArity = 0;
+    std::vector<vtkIdType> m_faceOffsets;
+    std::vector<vtkIdType> m_heVertex;
+    std::vector<vtkIdType> m_heFace;
+    std::vector<vtkIdType> m_heOpposite;
+    std::vector<vtkIdType> m_starOffsets;
+    std::vector<vtkIdType> m_star;
+    std::vector<vtkIdType> m_neighborOffsets;
+    std::vector<vtkIdType> m_neighbors;
+    std::vector<Edge> m_edges;
+};
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+
+/**
+ * Memory mapping of a whole file, the pages are loaded on access and written back by the system, so a mapping can be
+ * larger than the memory.
+ * Throws std::runtime_error when the file cannot be opened or mapped.
+ */
+class MappedFile {
+   public:
+    enum class Mode { Read, ReadWrite };
+
+    MappedFile(const std::filesystem::path& path, Mode mode);
+    ~MappedFile();
+    MappedFile(MappedFile&) = delete;
+    MappedFile(MappedFile&&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile& operator=(MappedFile&&) = delete;
+
+    /**
+     * Creates or truncates the file at the given size, filled with zeros.
+     */
+    static void create(const std::filesystem::path& path, std::size_t size);
+
+    std::size_t size() const { return m_size; }
+
+    template <typename T>
+    T* at(std::size_t offset) const {
+        return reinterpret_cast<T*>(static_cast<std::byte*>(m_data) + offset);
+    }
+
+    /**
+     * Writes the modified pages back to the file.
+     */
+    void flush();
+
+   private:
+    void* m_data = nullptr;
+    std::size_t m_size = 0;
+#ifdef _WIN32
+    void* m_file = nullptr;
+    void* m_mapping = nullptr;
+#else
+    int m_file = -1;
+#endif  // _WIN32
+};
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+#include <vtkType.h>
+
+#include <Eigen/Core>
+#include <Eigen/SparseCore>
+#include <memory>
+#include <memory_resource>
+#include <span>
+#include <vector>
+
+#include "HalfEdgeMesh.hpp"
+
+/**
+ * Face normals and areas, vertex normals and areas, and the cotangents of the corners of every triangle of a mesh.
+ *
+ * Faces that are not triangles are split in the triangles of a fan around their first corner, as in
+ * HalfEdgeMesh::forEachTriangle, the triangles of face f are numbered from firstTriangle(f).
+ * The geometry is built once per mesh and patched in place by update() after a deformation, so that a local edit only
+ * recomputes the faces touching the moved vertices.
+ */
+class MeshGeometry {
+   public:
+    MeshGeometry(vtkPolyData* mesh, std::shared_ptr<const HalfEdgeMesh> topology);
+
+    /**
+     * Returns the geometry of a mesh, it is rebuilt when the points were modified without calling update().
+     *
+     * @param mesh The vtkPolyData mesh.
+     *
+     * @return A shared pointer to the geometry of the mesh.
+     */
+    static std::shared_ptr<const MeshGeometry> get(vtkPolyData* mesh);
+
+    /**
+     * @return the cached geometry of the mesh if it is up to date, nullptr otherwise.
+     */
+    static std::shared_ptr<const MeshGeometry> find(vtkPolyData* mesh);
+
+    /**
+     * Recomputes the cached geometry around the vertices moved by a deformation, the points must have been marked
+     * modified before. Does nothing if the geometry of the mesh was not built, must not be called while another
+     * thread reads the geometry of the same mesh.
+     *
+     * @param mesh The vtkPolyData mesh.
+     * @param movedVertices The vertices whose position changed since the geometry was last up to date.
+     */
+    static void update(vtkPolyData* mesh, std::span<const vtkIdType> movedVertices);
+
+    /**
+     * @return the number of bytes of the geometry of a mesh.
+     */
+    static std::size_t predictBytes(vtkPolyData* mesh);
+
+    /**
+     * The Simplicial LDLT of a cotangent stiffness matrix with an AMD ordering, in multiples of the nonzeros of the
+     * matrix.
+     */
+    static constexpr std::size_t ldltFillFactor = 10;
+
+    /**
+     * @return the number of nonzeros of the cotangent stiffness matrix of a mesh, from the sizes of its faces.
+     */
+    static std::size_t predictStiffnessNonZeros(vtkPolyData* mesh);
+
+    std::size_t memoryBytes() const;
+
+    const HalfEdgeMesh& topology() const { return *m_topology; }
+
+    Eigen::Map<const Eigen::Vector3d> faceNormal(vtkIdType f) const {
+        return Eigen::Map<const Eigen::Vector3d>(m_faceNormals.data() + 3 * f);
+    }
+    double faceArea(vtkIdType f) const { return m_faceAreas[f]; }
+
+    /**
+     * @return the unit normal of the vertex v, the mean of the normals of its faces weighted by their areas.
+     */
+    Eigen::Map<const Eigen::Vector3d> vertexNormal(vtkIdType v) const {
+        return Eigen::Map<const Eigen::Vector3d>(m_vertexNormals.data() + 3 * v);
+    }
+
+    /**
+     * @return the barycentric area of the vertex v, an equal share of the area of each of its faces.
+     */
+    double vertexArea(vtkIdType v) const { return m_vertexAreas[v]; }
+
+    vtkIdType firstTriangle(vtkIdType f) const { return m_topology->faceHalfEdge(f) - 2 * f; }
+
+    /**
+     * @return the cotangent of the corner k of the triangle t, the corners are in the order of forEachTriangle.
+     */
+    double cotangent(vtkIdType t, int k) const { return m_cotangents[3 * t + k]; }
+
+    /**
+     * Appends the entries of the cotangent stiffness matrix, -(cot a + cot b) / 2 on an edge and the opposite of the
+     * sum of its row on the diagonal, positive semi-definite. Every edge of every triangle adds four triplets, summed
+     * by setFromTriplets.
+     */
+    void cotangentStiffness(std::pmr::vector<Eigen::Triplet<double>>& triplets) const;
+
+    /**
+     * @return the mean length of the edges of the mesh, 0 when it has none.
+     */
+    double meanEdgeLength(vtkPoints* points) const;
+
+   private:
+    void computeFace(vtkPoints* points, vtkIdType f);
+    void computeVertex(vtkIdType v);
+    void patch(vtkPoints* points, std::span<const vtkIdType> movedVertices);
+
+    std::shared_ptr<const HalfEdgeMesh> m_topology;
+    std::vector<double> m_faceNormals;
+    std::vector<double> m_faceAreas;
+    std::vector<double> m_vertexNormals;
+    std::vector<double> m_vertexAreas;
+    std::vector<double> m_cotangents;
+};
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <vtkPolyData.h>
+#include <vtkSmartPointer.h>
+
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <stop_token>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ThreadPool.hpp"
+#include "meshSharing.hpp"
+
+/**
+ * Reads mesh files on worker threads, several files at once, so that the interface keeps running while they load.
+ * A worker hashes the file, takeFinished() then looks for a mesh of the same file already loaded on the main thread,
+ * between two frames where no deformation runs, and only the files that are not loaded yet are read by a worker.
+ * The meshes read share their arrays with the meshes loaded when takeFinished() hands them back to the main thread,
+ * which adds their actors.
+ */
+class MeshLoader {
+   public:
+    /**
+     * Part of the progress of a load given to the reading of the file, the triangulation and the reordering that
+     * follow are the rest of it.
+     */
+    static constexpr double readFraction = 0.9;
+
+    struct Load {
+        std::filesystem::path path;
+        bool reorder = false;
+        std::uintmax_t bytes = 0;
+        std::stop_source stop;
+        std::atomic<double> progress = 0.0;
+        std::atomic<bool> keyed = false;  // the key is computed, the file can be looked up or read
+        std::atomic<bool> done = false;
+        bool reading = false;  // the file is read by a worker, it was not loaded yet
+        std::uint64_t key = 0;
+        MeshHashes hashes;
+        vtkSmartPointer<vtkPolyData> mesh;  // nullptr when the load failed or was cancelled
+        std::string error;
+        double seconds = 0.0;
+    };
+
+    explicit MeshLoader(unsigned nbThreads = std::thread::hardware_concurrency());
+    /**
+     * Cancels the loads and waits for the running ones, which stop within a block of lines for the OBJ files.
+     */
+    ~MeshLoader();
+    MeshLoader(MeshLoader&) = delete;
+    MeshLoader(MeshLoader&&) = delete;
+    MeshLoader& operator=(const MeshLoader&) = delete;
+    MeshLoader& operator=(MeshLoader&&) = delete;
+
+    /**
+     * Queues the load of an OBJ or PLY file, see loadMesh.
+     */
+    void load(const std::filesystem::path& path, bool reorder);
+
+    /**
+     * Starts reading the files hashed that are not loaded yet, and removes the finished loads, cancelled and failed
+     * ones included. Must be called from the main thread, between two frames, see findSharedMesh.
+     */
+    std::vector<std::unique_ptr<Load>> takeFinished();
+
+    /**
+     * @return the fraction of the bytes of the loads in progress that are read.
+     */
+    double progress() const;
+
+    const std::vector<std::unique_ptr<Load>>& loads() const { return m_loads; }
+
+   private:
+    /**
+     * Shares the mesh of a file already loaded, or reads the file on a worker.
+     */
+    void startReading(Load& load);
+
+    std::vector<std::unique_ptr<Load>> m_loads;
+    ThreadPool m_pool;
+};
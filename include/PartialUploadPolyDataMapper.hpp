@@ -0,0 +1,60 @@
+#pragma once
+
+#include <vtkActor.h>
+#include <vtkOpenGLPolyDataMapper.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+#include <vtkRenderer.h>
+#include <vtkType.h>
+#include <vtkWeakPointer.h>
+
+#include <utility>
+#include <vector>
+
+/**
+ * Polydata mapper that sends only the modified points to the GPU when the points are the only thing that changed
+ * since the last upload, the index buffers and the other attributes are left untouched.
+ * Any other change goes through the full upload of vtkOpenGLPolyDataMapper.
+ */
+class PartialUploadPolyDataMapper : public vtkOpenGLPolyDataMapper {
+   public:
+    static PartialUploadPolyDataMapper* New();
+    vtkTypeMacro(PartialUploadPolyDataMapper, vtkOpenGLPolyDataMapper);
+
+    // a buffer update per range costs about as much as sending a few hundred points more
+    static constexpr vtkIdType mergeGap = 256;
+
+    /**
+     * Reports the points [begin, end) as modified in place, the ranges reported before the next render are uploaded
+     * together, the overlapping ones and those separated by less than mergeGap points merged.
+     * When the points changed without a report, all of them are uploaded again.
+     */
+    void addModifiedPoints(vtkIdType begin, vtkIdType end);
+
+    /**
+     * @return true when the buffers of the input depend on its cell attributes, the cell scalars selected for the
+     * coloring or the cell normals, which are only uploaded by the full upload. The other cell arrays, such as the
+     * original ids of reorderForLocality, are not uploaded and do not prevent the partial upload.
+     */
+    bool uploadsCellAttributes(vtkPolyData* input) const;
+
+    /**
+     * @return the number of uploads of every buffer and of uploads of the modified points only, since the creation
+     * of the mapper.
+     */
+    int fullUploads() const { return m_fullUploads; }
+    int partialUploads() const { return m_partialUploads; }
+
+   protected:
+    void UpdateBufferObjects(vtkRenderer* ren, vtkActor* act) override;
+    void BuildBufferObjects(vtkRenderer* ren, vtkActor* act) override;
+
+   private:
+    bool onlyPointsModified(vtkActor* act) const;
+    bool uploadPoints(std::vector<std::pair<vtkIdType, vtkIdType>>& ranges);
+
+    vtkWeakPointer<vtkPoints> m_uploadedPoints;
+    std::vector<std::pair<vtkIdType, vtkIdType>> m_modified;
+    int m_fullUploads = 0;
+    int m_partialUploads = 0;
+};
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+#include <vtkType.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <memory>
+#include <vector>
+
+/**
+ * Uniform grid over the points of a mesh, for the queries by Euclidean distance.
+ *
+ * The points are sorted by cell with a parallel radix sort, every cell is a range of the sorted ids, and the positions
+ * are copied in the same order so that a query reads contiguous memory. The cell size makes about one cell per point
+ * in the bounding box, it is enlarged for flat meshes so that the cells never outnumber the points by more than 4.
+ * A radius query visits the cells overlapping the bounding box of the sphere, its cost depends on the points around
+ * the center, not on the size of the mesh.
+ */
+class PointGrid {
+   public:
+    explicit PointGrid(vtkPoints* points);
+
+    /**
+     * Returns the grid of the points of a mesh, it is built once and reused as long as the points are not modified,
+     * by every mesh sharing the same points.
+     */
+    static std::shared_ptr<const PointGrid> get(vtkPolyData* mesh);
+
+    /**
+     * @return the cached grid of the mesh if it is up to date, nullptr otherwise.
+     */
+    static std::shared_ptr<const PointGrid> find(vtkPolyData* mesh);
+
+    /**
+     * @return the number of bytes of the grid of a mesh.
+     */
+    static std::size_t predictBytes(vtkPolyData* mesh);
+
+    std::size_t memoryBytes() const;
+
+    /**
+     * Calls fn(pointId, squaredDistance) on every point within radius of center.
+     */
+    template <typename Fn>
+    void forEachInRadius(const double center[3], double radius, Fn&& fn) const {
+        if (m_ids.empty() || radius < 0.0) return;
+        std::array<int, 3> low, high;
+        for (int k = 0; k < 3; ++k) {
+            low[k] = cellCoordinate(center[k] - radius, k);
+            high[k] = cellCoordinate(center[k] + radius, k);
+        }
+        const double squaredRadius = radius * radius;
+        for (int z = low[2]; z <= high[2]; ++z) {
+            for (int y = low[1]; y <= high[1]; ++y) {
+                // the cells of a row along x are contiguous
+                const auto row = (static_cast<vtkIdType>(z) * m_dims[1] + y) * m_dims[0];
+                for (vtkIdType i = m_cellStart[row + low[0]]; i < m_cellStart[row + high[0] + 1]; ++i) {
+                    const double* p = m_positions.data() + 3 * i;
+                    const double dx = p[0] - center[0];
+                    const double dy = p[1] - center[1];
+                    const double dz = p[2] - center[2];
+                    const double squaredDistance = dx * dx + dy * dy + dz * dz;
+                    if (squaredDistance <= squaredRadius) fn(m_ids[i], squaredDistance);
+                }
+            }
+        }
+    }
+
+   private:
+    int cellCoordinate(double x, int k) const {
+        // clamped before the conversion, a coordinate far outside of the grid does not fit in an int
+        return static_cast<int>(std::clamp(std::floor((x - m_origin[k]) / m_cellSize), 0.0, m_dims[k] - 1.0));
+    }
+
+    std::array<double, 3> m_origin = {0.0, 0.0, 0.0};
+    double m_cellSize = 1.0;
+    std::array<int, 3> m_dims = {1, 1, 1};
+    std::vector<vtkIdType> m_cellStart;
+    std::vector<vtkIdType> m_ids;
+    std::vector<double> m_positions;
+};
@@ -0,0 +1,136 @@
+#pragma once
+
+#include <vtkPolyData.h>
+#include <vtkType.h>
+#include <vtkWeakPointer.h>
+
+#include <Eigen/Eigen>
+#include <chrono>
+#include <functional>
+#include <map>
+#include <memory>
+#include <memory_resource>
+#include <unordered_map>
+#include <vector>
+
+class HalfEdgeMesh;
+
+/**
+ * The inputs of a weight field, the field is computed again as soon as one of them changes.
+ */
+struct WeightParameters {
+    vtkPolyData* mesh = nullptr;
+    vtkIdType pointId = -1;
+    int method = 0;
+    int ringCount = 0;
+    double alpha = 0.0;
+    int nbModes = 0;
+    double radius = 0.0;
+    vtkMTimeType pointsTime = 0;  // modification time of the points, the field is stale once they moved
+
+    bool operator==(const WeightParameters&) const = default;
+};
+
+/**
+ * Weight field of weightingFunction computed over several frames, so that a pick on a large mesh shows a coarse field
+ * within the frame and refines it without freezing the interface.
+ *
+ * The computation is resumable: refine runs it for a time budget and returns, the next call continues where it
+ * stopped. The first step publishes the ring falloff of simpleHarmonic over the support of the field, then
+ * - the laplacian diffusion runs its iterations, possibly split between frames, and publishes each completed one,
+ *   the final field is the one of laplacianDiffusion;
+ * - the laplace equations are assembled in steps, the ring search, the faces of the rings, their cotangent entries
+ *   and the matrix, the first three resumed within the budget, then solved iteratively from the scaled falloff, by
+ *   BiCGSTAB, each frame publishing the current iterate until the relative residual reaches tolerance;
+ * - the other methods are computed at once by weightingFunction.
+ *
+ * Everything kept between the frames is allocated from the default resource, the ScratchArena only holds the
+ * temporaries of a single step.
+ */
+class ProgressiveWeights {
+   public:
+    static constexpr double tolerance = 1e-10;
+
+    /**
+     * @return true when the field of the parameters is the one computed or being computed.
+     */
+    bool computes(const WeightParameters& parameters) const;
+
+    /**
+     * Drops the current field and starts the computation of the field of the parameters, nothing is computed before
+     * the next call to refine.
+     */
+    void start(const WeightParameters& parameters);
+
+    /**
+     * Drops the current field, refine does nothing until the next start.
+     */
+    void stop();
+
+    /**
+     * Advances the computation for about the budget, at least one step is done so that every call makes progress.
+     *
+     * @return true when the published weights changed.
+     */
+    bool refine(std::chrono::duration<double> budget);
+
+    bool running() const { return m_stage != Stage::Idle && m_stage != Stage::Done; }
+    bool finished() const { return m_stage == Stage::Done; }
+
+    /**
+     * @return an estimate of the fraction of the computation done, 1 once finished.
+     */
+    double progress() const;
+
+    const WeightParameters& parameters() const { return m_parameters; }
+
+    /**
+     * @return the last published weights, they do not change when the computation goes on.
+     */
+    std::function<double(vtkIdType)> weights() const { return m_weights; }
+
+   private:
+    enum class Stage { Idle, Coarse, Diffusion, Rings, Faces, Triplets, Matrix, Solve, Done };
+    using ValueMap = std::unordered_map<vtkIdType, double>;
+
+    void coarseStep();
+    bool diffusionStep(std::chrono::steady_clock::time_point deadline);
+    void ringsStep(std::chrono::steady_clock::time_point deadline);
+    void facesStep(std::chrono::steady_clock::time_point deadline);
+    void tripletsStep(std::chrono::steady_clock::time_point deadline);
+    void matrixStep();
+    void solveStep(std::chrono::steady_clock::time_point deadline);
+    void publishDiffusion();
+    void publishSolution();
+
+    WeightParameters m_parameters;
+    vtkWeakPointer<vtkPolyData> m_mesh;
+    Stage m_stage = Stage::Idle;
+    std::function<double(vtkIdType)> m_weights;
+
+    // laplacian diffusion, the values of the last completed iteration and of the current one
+    std::shared_ptr<const HalfEdgeMesh> m_topology;
+    std::shared_ptr<ValueMap> m_current;
+    std::shared_ptr<ValueMap> m_next;
+    int m_iteration = 0;
+    vtkIdType m_nextPoint = 0;
+
+    // laplace equations, the points of the rings in the order of the breadth-first search, which is the order of the
+    // rows, and the next point or face of the step being resumed
+    std::pmr::unordered_map<vtkIdType, long> m_ringMap;
+    std::vector<vtkIdType> m_ringPoints;
+    std::size_t m_nextRingPoint = 0;
+    std::shared_ptr<std::pmr::map<vtkIdType, long>> m_rows;
+    long m_lastRingStart = 0;
+    std::pmr::vector<vtkIdType> m_ringFaces;
+    std::size_t m_nextFace = 0;
+    std::pmr::vector<Eigen::Triplet<double>> m_triplets;
+    Eigen::SparseMatrix<double> m_matrix;
+    Eigen::VectorXd m_rhs;
+    Eigen::VectorXd m_solution;
+    Eigen::BiCGSTAB<Eigen::SparseMatrix<double>> m_solver;
+    double m_initialError = 1.0;
+    double m_error = 1.0;
+    int m_solverIterations = 8;  // iterations of the next call to the solver, adapted to the budget
+    Eigen::Index m_totalIterations = 0;
+};
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstddef>
+#include <memory_resource>
+
+struct ArenaCounters {
+    std::size_t allocations = 0;  // allocations served by the arena
+    std::size_t bytes = 0;        // bytes allocated from the arena
+    std::size_t heapBlocks = 0;   // blocks requested from the heap, 0 when the retained buffer was large enough
+};
+
+/**
+ * Monotonic arena of the temporaries of the compute calls, one per thread.
+ *
+ * The arena is open while a MemoryScope is alive on the thread, and everything allocated from it is released at once
+ * when the outermost scope ends, so the many small allocations of the maps and vectors of a pick are pointer bumps.
+ * The first buffer is kept between operations and grown to the size of the largest one, up to retainedLimit, so that
+ * repeating an operation does not allocate from the heap at all.
+ *
+ * Containers allocated from the arena must not outlive the operation. The results are copied out, the copy of a pmr
+ * container uses the default resource.
+ */
+class ScratchArena {
+   public:
+    static constexpr std::size_t retainedLimit = std::size_t{64} << 20;
+
+    /**
+     * @return the arena of the current thread while an operation runs, the default resource otherwise.
+     */
+    static std::pmr::memory_resource* resource();
+
+    /**
+     * Opens the arena of the current thread, nested calls share it.
+     */
+    static void acquire();
+
+    /**
+     * Releases every allocation of the arena when the outermost acquire ends.
+     *
+     * @return the counters of the operation, zeros for a nested release.
+     */
+    static ArenaCounters release();
+
+    /**
+     * @return the counters of every operation since the start, on every thread.
+     */
+    static ArenaCounters totals();
+};
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <vtkType.h>
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+/**
+ * An operation of an interactive session, with the parameters needed to replay it.
+ */
+struct SessionAction {
+    enum class Type { Open, Pick, Weight, Translate, Smooth, Fair, Batch };
+
+    Type type = Type::Open;
+    double time = 0.0;               // seconds since the start of the recording
+    std::string name;                // the file of Open, the actor of Pick, Smooth and Fair
+    std::vector<std::string> names;  // the actors of Batch
+    int operation = 0;               // the operation of Batch, 0 laplacian smoothing, 1 laplacian diffusion
+    bool reorder = false;
+    vtkIdType pointId = -1;  // the point of Pick, the seed point of Batch
+    int method = 0;
+    int ringCount = 0;
+    double alpha = 0.0;
+    int modes = 0;
+    double radius = 0.0;
+    double distance = 0.0;
+    int iterations = 0;  // the iterations of Smooth and Batch
+    double stepSize = 0.0;
+    int weights = 0;
+    bool biLaplacian = false;
+};
+
+/**
+ * Writes the operations of an interactive session to a text log, one line per operation flushed as soon as it is
+ * recorded so that the log survives a crash:
+ *
+ *     <time> open <reorder> <path>
+ *     <time> pick <point id> <actor>
+ *     <time> weight <method> <ring count> <alpha> <modes> <radius>
+ *     <time> translate <method> <ring count> <alpha> <modes> <distance> <radius>
+ *     <time> smooth <iterations> <actor>
+ *     <time> fair <step size> <weights> <bi-laplacian> <actor>
+ *     <time> batch <operation> <iterations> <seed point> <alpha> "<actor>" "<actor>"...
+ *
+ * The weight and translate operations apply to the last pick. The actors of a batch are quoted, as by std::quoted.
+ * The record functions do nothing when not recording.
+ */
+class SessionRecorder {
+   public:
+    /**
+     * Starts a new log, throws std::runtime_error when the file cannot be created.
+     */
+    void start(const std::filesystem::path& path);
+    void stop();
+    bool recording() const { return m_file.is_open(); }
+
+    void recordOpen(const std::filesystem::path& path, bool reorder);
+    /**
+     * Only written when the actor or the point differ from the last recorded pick.
+     */
+    void recordPick(const std::string& actorName, vtkIdType pointId);
+    void recordWeight(int method, int ringCount, double alpha, int modes, double radius);
+    void recordTranslate(int method, int ringCount, double alpha, int modes, double radius, double distance);
+    void recordSmooth(const std::string& actorName, int iterations);
+    void recordFairing(const std::string& actorName, double stepSize, int weights, bool biLaplacian);
+    /**
+     * @param operation 0 laplacian smoothing, 1 laplacian diffusion from the seed point, see Tools::batchSection
+     */
+    void recordBatch(const std::vector<std::string>& actorNames, int operation, int iterations, vtkIdType seedPoint,
+                     double alpha);
+
+   private:
+    void write(const std::string& line);
+    std::ofstream m_file;
+    std::chrono::steady_clock::time_point m_start;
+    std::string m_lastPickName;
+    vtkIdType m_lastPickId = -1;
+};
+
+/**
+ * Reads a log written by SessionRecorder, throws std::runtime_error on a malformed line.
+ */
+std::vector<SessionAction> readSessionLog(const std::filesystem::path& path);
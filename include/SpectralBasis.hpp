@@ -0,0 +1,106 @@
+#pragma once
+
+#include <vtkPolyData.h>
+#include <vtkType.h>
+
+#include <Eigen/Core>
+#include <functional>
+#include <memory>
+#include <span>
+#include <string>
+
+#include "HalfEdgeMesh.hpp"
+
+/**
+ * The first eigenpairs of the cotangent Laplacian of a mesh, L phi = lambda M phi with M the lumped mass matrix of the
+ * vertex areas, the eigenvectors being M-orthonormal.
+ *
+ * They are computed once per mesh by a shift-invert Lanczos iteration, after which the heat kernel of any vertex is a
+ * truncated spectral sum: a weight query costs O(k) for k modes, instead of diffusion iterations or a sparse solve.
+ * The basis depends on the positions of the points, it is computed again after a deformation.
+ */
+class SpectralBasis : public std::enable_shared_from_this<SpectralBasis> {
+   public:
+    /**
+     * The basis has fewer modes than requested when the Krylov space of the mesh is smaller, and none when the mesh is
+     * empty or its Laplacian cannot be factorized, error() then tells why.
+     *
+     * @param nbModes The number of eigenpairs, at most the number of points.
+     */
+    SpectralBasis(vtkPolyData* mesh, int nbModes);
+
+    /**
+     * Returns the basis of a mesh with at least nbModes modes, it is computed once and reused as long as the points
+     * and polygons are not modified.
+     */
+    static std::shared_ptr<const SpectralBasis> get(vtkPolyData* mesh, int nbModes);
+
+    /**
+     * @return the cached basis of the mesh if it is up to date, nullptr otherwise.
+     */
+    static std::shared_ptr<const SpectralBasis> find(vtkPolyData* mesh);
+
+    /**
+     * @return the peak number of bytes needed to compute the basis, the topology and geometry excluded.
+     */
+    static std::size_t predictBytes(vtkPolyData* mesh, int nbModes);
+
+    std::size_t memoryBytes() const;
+
+    int numberOfModes() const { return static_cast<int>(m_eigenvalues.size()); }
+    // the number of modes asked for, numberOfModes() is smaller when the mesh does not have that many
+    int requestedModes() const { return m_requestedModes; }
+    // why the basis has no modes, empty when it was computed
+    const std::string& error() const { return m_error; }
+    double eigenvalue(int i) const { return m_eigenvalues[i]; }
+    double meanEdgeLength() const { return m_meanEdgeLength; }
+
+    /**
+     * @return the values of the modes at the vertex v.
+     */
+    auto modes(vtkIdType v) const { return m_modes.row(v); }
+
+    /**
+     * Heat diffused from the vertex ptId during time, sum_i exp(-lambda_i time) phi_i(ptId) phi_i(v) over the first
+     * nbModes modes, all of them when nbModes is 0, 0 everywhere without modes. The function keeps the basis alive,
+     * each call costs O(nbModes).
+     * The basis must be owned by a shared_ptr, as the ones returned by get().
+     */
+    std::function<double(vtkIdType)> heatKernel(vtkIdType ptId, double time, int nbModes = 0) const;
+
+    /**
+     * Writes the heat kernel of ptId at every vertex, the truncated spectral sums being computed in parallel.
+     *
+     * @param values one value per vertex of the mesh
+     */
+    void heatKernel(vtkIdType ptId, double time, int nbModes, std::span<float> values) const;
+
+   private:
+    // exp(-lambda_i time) phi_i(ptId) of the first k modes, the heat kernel at v is their dot product with phi(v)
+    Eigen::VectorXd heatCoefficients(vtkIdType ptId, double time, int k) const;
+
+    std::shared_ptr<const HalfEdgeMesh> m_topology;
+    Eigen::VectorXd m_eigenvalues;
+    // one row per vertex, so that the modes of a vertex are contiguous
+    Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> m_modes;
+    double m_meanEdgeLength = 0.0;
+    int m_requestedModes = 0;
+    std::string m_error;
+};
+
+/**
+ * Heat diffusion from the picked point evaluated in the spectral basis of the mesh, the basis is computed on the
+ * first call. The time of iterations steps of laplacianDiffusion with the given alpha is alpha * iterations * h^2 / 4
+ * on a regular triangulation of edge length h, it is used with the mean edge length so that both methods spread over
+ * comparable regions.
+ *
+ * @param nbModes The number of modes of the truncated spectral sum.
+ */
+std::function<double(vtkIdType)> spectralDiffusion(vtkPolyData* mesh, vtkIdType ptId, double alpha, int iterations,
+                                                   int nbModes);
+
+/**
+ * Writes the spectral diffusion at every point of the mesh, see heatKernel.
+ */
+void spectralDiffusion(vtkPolyData* mesh, vtkIdType ptId, double alpha, int iterations, int nbModes,
+                       std::span<float> values);
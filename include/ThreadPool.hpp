@@ -0,0 +1,34 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <stop_token>
+#include <thread>
+#include <vector>
+
+/**
+ * Fixed set of worker threads consuming a FIFO queue of tasks.
+ * Pending tasks are dropped when the pool is destroyed, running tasks are waited for.
+ */
+class ThreadPool {
+   public:
+    explicit ThreadPool(unsigned nbThreads = std::thread::hardware_concurrency());
+    ~ThreadPool();
+    ThreadPool(ThreadPool&) = delete;
+    ThreadPool(ThreadPool&&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+    ThreadPool& operator=(ThreadPool&&) = delete;
+
+    void submit(std::function<void()> task);
+    unsigned size() const { return m_workers.size(); }
+
+   private:
+    void work(std::stop_token stopToken);
+
+    std::mutex m_mutex;
+    std::condition_variable_any m_condition;
+    std::deque<std::function<void()>> m_tasks;
+    std::vector<std::jthread> m_workers;
+};
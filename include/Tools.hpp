@@ -3,12 +3,21 @@
 #include <vtkNew.h>
 #include <vtkRenderer.h>
 
+#include <set>
+#include <string>
+
+#include "BatchRunner.hpp"
 #include "MouseInteractorStylePP.hpp"
+#include "ProgressiveWeights.hpp"
+#include "SessionLog.hpp"
 
 class Tools {
    public:
     Tools() = delete;
-    Tools(vtkRenderer* renderer, MouseInteractorStylePP* picker, bool* picking);
+    /**
+     * @param recorder receives the operations applied through the windows
+     */
+    Tools(vtkRenderer* renderer, MouseInteractorStylePP* picker, bool* picking, SessionRecorder* recorder);
     Tools(Tools&) = delete;
     Tools(Tools&&) = delete;
     Tools& operator=(const Tools&) = delete;
@@ -23,20 +32,48 @@ class Tools {
     void enableDeformWindow();
     void cleanup();
 
+    /**
+     * @return the actor selected in the actors window, nullptr when there is none.
+     */
+    vtkActor* selectedActor() const;
+
    private:
+    void batchSection();
+    void memorySection(vtkActor* actor);
+    void progressiveSection(vtkActor* actor, vtkPolyData* polyData, vtkIdType pointId);
+    std::size_t predictWeightingBytes(vtkPolyData* polyData);
+    WeightParameters weightParameters(vtkPolyData* polyData, vtkIdType pointId) const;
+    bool allowOperation(std::size_t predictedBytes);
     int m_selectedActor = 0;
     bool m_showFnWindow = false;
     bool m_showActorsWindow = false;
     bool m_showDeformWindow = false;
     bool* m_picking;
+    SessionRecorder* m_recorder;
     float m_deformDistance = 0.01;
     int m_weightingMethod = 0;
     float m_alpha = 1.0 / 4.0;
     int m_ringCount = 1;
+    int m_spectralModes = 64;
+    float m_radius = 0.1f;
     float m_colorStart[3] = {1.0, 0.0, 0.0};
     float m_colorEnd[3] = {0.0, 0.0, 1.0};
     float m_colorNeutral[3] = {1.0, 1.0, 1.0};
+    bool m_progressive = false;
+    float m_frameBudgetMs = 8.0f;
+    ProgressiveWeights m_progressiveWeights;
     int m_smoothingIterations = 1;
+    int m_smoothingMode = 0;
+    float m_fairingStep = 1.0f;
+    int m_fairingWeights = 0;
+    bool m_fairingBiLaplacian = false;
+    int m_batchOperation = 0;
+    int m_batchSeed = 0;
+    std::set<vtkActor*> m_batchActors;
+    int m_memoryCeilingMiB = 0;
+    std::string m_memoryWarning;
+    std::string m_deformError;
+    BatchRunner m_batch;
     vtkActor* m_toRemove = nullptr;
     vtkRenderer* m_renderer;
     MouseInteractorStylePP* m_picker;
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <vtkPolyData.h>
+#include <vtkType.h>
+
+#include <functional>
+#include <span>
+
+/**
+ * Paints every point of the mesh with the same color, adding a vertex cell per point so that they are drawn.
+ *
+ * @param color rgb components between 0 and 1
+ */
+void colorizeMesh(vtkPolyData* polyData, const float* color);
+
+/**
+ * Paints the points of positive weight with a gradient from colorEnd to colorStart, the weights being normalized by
+ * the weight of the picked point, and the other points with colorNeutral. The vertex cells and the colors are those of
+ * colorizeMesh, the whole mesh is painted in a single parallel pass writing the bytes of the color array in place:
+ * the normalized weight of a point selects one of the levels of the gradient, interpolated beforehand.
+ * Nothing is painted when the weights are not those of the points of the mesh or pointId is not a point of the mesh.
+ *
+ * @param weights the weight of every point, from weightingValues
+ */
+void colorizeWeights(vtkPolyData* polyData, vtkIdType pointId, std::span<const float> weights,
+                     const float* colorNeutral, const float* colorStart, const float* colorEnd);
+
+/**
+ * Same as above for a weight function, evaluated on every point from the calling thread into the buffer of weights.
+ */
+void colorizeWeights(vtkPolyData* polyData, vtkIdType pointId, const std::function<double(vtkIdType)>& harmonic,
+                     const float* colorNeutral, const float* colorStart, const float* colorEnd);
@@ -4,6 +4,19 @@
 #include <vtkType.h>
 
 #include <functional>
+#include <span>
+#include <vector>
+
+/**
+ * The points [begin, end) modified in place by a deformation, so that only they are uploaded again to the GPU.
+ * The deformations first give the mesh its own points when they are shared with another mesh, see detachSharedPoints.
+ */
+struct PointRange {
+    vtkIdType begin = 0;
+    vtkIdType end = 0;
+
+    bool empty() const { return begin >= end; }
+};
 
 /**
  * Performs Laplacian smoothing on a vtkPolyData mesh.
@@ -11,17 +24,63 @@
  *
  * @param mesh The vtkPolyData mesh to be smoothed.
  * @param numIterations The number of smoothing iterations to be performed.
+ * @param progress optional callback receiving the fraction of the iterations done
  *
+ * @return the modified points, all of them.
  */
-void laplacianSmoothing(vtkPolyData* mesh, int numIterations);
+PointRange laplacianSmoothing(vtkPolyData* mesh, int numIterations, const std::function<void(double)>& progress = {});
+
+enum class FairingWeights { Uniform, Cotangent };
+
+/**
+ * Implicit fairing, solves (I - stepSize L) x' = x for the three coordinates of the points at once, or
+ * (I + stepSize^2 L^2) x' = x with the bi-Laplacian, which one step of a large stepSize smooths as much as many
+ * iterations of laplacianSmoothing.
+ * The systems are solved in their symmetric form, L = -M^-1 K with M the degrees and K the graph Laplacian for the
+ * uniform weights, M the vertex areas and K the cotangent Laplacian for the cotangent weights. The cotangent step is
+ * scaled by the square of the mean edge length over 4, so that both weightings smooth about as much for a stepSize.
+ *
+ * The factorization is cached per mesh and parameters, applying the same smoothing again only solves. The cotangent
+ * operator keeps the positions of the mesh when it was factorized, the usual fixed operator approximation of the
+ * fairing, it is factorized again when the parameters, the points array or the polygons change.
+ *
+ * @param mesh The vtkPolyData mesh to be smoothed.
+ * @param stepSize lambda * dt, the amount of smoothing
+ * @param weights The weights of the Laplacian.
+ * @param biLaplacian Smooths with the square of the Laplacian, which keeps more of the shape at the same stepSize.
+ *
+ * @return the modified points, all of them.
+ */
+PointRange implicitFairing(vtkPolyData* mesh, double stepSize, FairingWeights weights, bool biLaplacian);
 
 /**
  * Translates a point in the mesh by dis in the normal direction and weighted by the weight function
+ * Only the points of the support are visited, they are moved in place and the cached geometry is only updated around
+ * the points with a non zero weight.
  *
  * @param mesh a pointer to the vtkPolyData object representing the mesh
  * @param ptId the ID of the point in the mesh
  * @param dist the distance to translate the point
  * @param weightFn
+ * @param support the sorted ids of the points where weightFn may be non zero, see weightingSupport
  *
+ * @return the ranges of consecutive moved points, in increasing order.
+ */
+std::vector<PointRange> weightedTranslate(vtkPolyData* mesh, vtkIdType ptId, double dist,
+                                          const std::function<double(vtkIdType)>& weightFn,
+                                          std::span<const vtkIdType> support);
+
+/**
+ * Predicts the peak bytes of the temporaries of laplacianSmoothing, the copy of the points.
+ */
+std::size_t predictLaplacianSmoothingBytes(vtkPolyData* mesh);
+
+/**
+ * Predicts the peak bytes of implicitFairing, the operator and its factorization when they are not cached.
+ */
+std::size_t predictImplicitFairingBytes(vtkPolyData* mesh, double stepSize, FairingWeights weights, bool biLaplacian);
+
+/**
+ * @return the bytes of the cached fairing factorization of the mesh, 0 if none.
  */
-void weightedTranslate(vtkPolyData* mesh, vtkIdType ptId, double dist, std::function<double(vtkIdType)> weightFn);
\ No newline at end of file
+std::size_t implicitFairingCacheBytes(vtkPolyData* mesh);
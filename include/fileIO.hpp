@@ -2,13 +2,65 @@
 
 #include <nfd.h>
 #include <vtkActor.h>
+#include <vtkPolyData.h>
 #include <vtkRenderer.h>
+#include <vtkSmartPointer.h>
 
 #include <filesystem>
+#include <functional>
 #include <optional>
+#include <stop_token>
+#include <string>
 
 std::optional<std::filesystem::path> pickModelFile();
+std::optional<std::filesystem::path> pickSaveFile(const std::string& defaultName);
 
-void openObjectFile(const std::filesystem::path& path, vtkRenderer* renderer);
+/**
+ * Reads an OBJ or PLY mesh the way it is opened in the renderer, without creating an actor nor looking for a mesh of
+ * the same file already loaded. It does not touch the meshes loaded and may run on a loading thread.
+ *
+ * Only the positions and the polygons of the OBJ files are read, by parseObj.
+ *
+ * @param progress optional callback receiving the fraction of the file read, from the bytes parsed for the OBJ files
+ * and from the progress events of the reader for the PLY files
+ * @param stopToken stops the OBJ parse within a block of lines, and aborts the PLY reader at its next progress event,
+ * when a stop is requested
+ *
+ * @return the mesh, nullptr when the extension is not supported or the read was stopped.
+ */
+vtkSmartPointer<vtkPolyData> readMesh(const std::filesystem::path& path, bool reorder = false,
+                                      const std::function<void(double)>& progress = {},
+                                      std::stop_token stopToken = {});
 
-void openPLYFile(const std::filesystem::path& path, vtkRenderer* renderer);
+/**
+ * Reads a mesh with readMesh, unless a file with the same content is already loaded: files with the same content
+ * share their points, polygons and attribute arrays, see findSharedMesh, the deformations copy the points of a mesh
+ * before modifying them.
+ * Must be called from the main thread, MeshLoader loads the meshes in the background.
+ *
+ * @return the mesh, nullptr when the extension is not supported or the load was stopped.
+ */
+vtkSmartPointer<vtkPolyData> loadMesh(const std::filesystem::path& path, bool reorder = false,
+                                      const std::function<void(double)>& progress = {},
+                                      std::stop_token stopToken = {});
+
+/**
+ * Adds a mesh to the renderer in a new actor named after the file, must be called from the main thread.
+ */
+void addMeshActor(const std::filesystem::path& path, vtkPolyData* mesh, vtkRenderer* renderer);
+
+/**
+ * Loads a mesh in a new actor of the renderer.
+ *
+ * @param reorder Sorts the points and faces of the mesh for cache locality, see reorderForLocality.
+ */
+void openObjectFile(const std::filesystem::path& path, vtkRenderer* renderer, bool reorder = false);
+
+void openPLYFile(const std::filesystem::path& path, vtkRenderer* renderer, bool reorder = false);
+
+/**
+ * Writes a mesh to an OBJ or PLY file, in the order of the file it was loaded from when it was reordered on load.
+ * The PLY files keep the point colors.
+ * Throws std::runtime_error when the extension is not supported or the file cannot be written.
+ */
+void saveMesh(const std::filesystem::path& path, vtkPolyData* mesh);
@@ -5,31 +5,26 @@
 
 #include <Eigen/Eigen>
 #include <functional>
+#include <map>
+#include <memory_resource>
+#include <span>
 #include <unordered_map>
-#include <unordered_set>
+#include <utility>
+#include <vector>
+
+class HalfEdgeMesh;
 
 /**
  * Utility function that builds a ring map for a mesh given an initial point , and the number of rings.
- * read the entire mesh ringCount times
+ * only the faces around the visited points are read, through the cached HalfEdgeMesh of the mesh
  *
  * @param mesh The vtkPolyData mesh to build the ring map from.
  * @param initPointId The initial point ID to start building the ring map from.
  * @param ringCount The number of rings to build in the ring map.
  *
- * @return An unordered map of vtkIdType to double representing the ring map.
+ * @return An unordered map of vtkIdType to double representing the ring map, allocated from the ScratchArena.
  */
-std::unordered_map<vtkIdType, long> buildRingMap(vtkPolyData* mesh, vtkIdType initPointId, long ringCount);
-
-/**
- * Builds a neighbor map for a given vtkPolyData triangle mesh.
- *
- * @param mesh A pointer to the vtkPolyData mesh.
- *
- * @return An unordered map with vtkIdType keys and unordered sets of vtkIdType values,
- *         representing the neighbor map.
- *
- */
-std::unordered_map<vtkIdType, std::unordered_set<vtkIdType>> buildNeighborMap(vtkPolyData* mesh);
+std::pmr::unordered_map<vtkIdType, long> buildRingMap(vtkPolyData* mesh, vtkIdType initPointId, long ringCount);
 
 /**
  * Generates an Harmonic function inversely proportial to the ring id.
@@ -52,12 +47,14 @@ std::function<double(vtkIdType)> simpleHarmonic(vtkPolyData* mesh, vtkIdType poi
  * @param ptId The ID of the point.
  * @param alpha diffusion parameter (between 0 and 1/2)
  * @param iterations the number of iterations
+ * @param progress optional callback receiving the fraction of the iterations done
  *
  * @return the laplacian diffusion
  *
  */
 std::function<double(vtkIdType)> laplacianDiffusion(vtkPolyData* mesh, vtkIdType ptId, double alpha,
-                                                    int iterations = 0);
+                                                    int iterations = 0,
+                                                    const std::function<void(double)>& progress = {});
 
 /**
  * Generates a Laplacian matrix for a given mesh and point ID.
@@ -73,8 +70,37 @@ std::function<double(vtkIdType)> laplacianDiffusion(vtkPolyData* mesh, vtkIdType
  * @throws None.
  */
 Eigen::SparseMatrix<double> laplacianMatrix(vtkPolyData* mesh, vtkIdType ptId,
-                                            const std::map<vtkIdType, long>& pointMap,
-                                            const std::unordered_map<vtkIdType, long>& ringMap, long lastRingStart);
+                                            const std::pmr::map<vtkIdType, long>& pointMap,
+                                            const std::pmr::unordered_map<vtkIdType, long>& ringMap,
+                                            long lastRingStart);
+
+/**
+ * Appends the faces of the mesh whose corners are all in the rings, among the faces around the points, each face
+ * being appended by one of its corners: over a partition of the points of the rings, the faces of laplacianMatrix.
+ */
+void appendRingFaces(const HalfEdgeMesh& topology, std::span<const vtkIdType> points,
+                     const std::pmr::unordered_map<vtkIdType, long>& ringMap, std::pmr::vector<vtkIdType>& faces);
+
+/**
+ * Appends the cotangent entries of the faces to the triplets of the matrix of laplacianMatrix, which is assembled from
+ * the faces of the rings in one call or in several ones. The rows of the last ring, from lastRingStart, are left to
+ * the caller.
+ */
+void addRingTriplets(vtkPolyData* mesh, std::span<const vtkIdType> faces,
+                     const std::pmr::map<vtkIdType, long>& pointMap, long lastRingStart,
+                     std::pmr::vector<Eigen::Triplet<double>>& triplets);
+
+/**
+ * Orders the points of the rings ring by ring, the point first and its last ring at the end.
+ *
+ * @param ringMap The ring of each point, from buildRingMap.
+ * @param ringCount The number of rings.
+ *
+ * @return the row of each point in the system of solveLaplace, allocated from the ScratchArena, and the first row of
+ * the last ring.
+ */
+std::pair<std::pmr::map<vtkIdType, long>, long> ringRows(const std::pmr::unordered_map<vtkIdType, long>& ringMap,
+                                                         int ringCount);
 
 /**
  * Solve the laplace equations
@@ -86,3 +112,62 @@ Eigen::SparseMatrix<double> laplacianMatrix(vtkPolyData* mesh, vtkIdType ptId,
  *
  */
 std::function<double(vtkIdType)> solveLaplace(vtkPolyData* mesh, vtkIdType ptId, int ringCount);
+
+/**
+ * Weights the points within a Euclidean radius of a point, found through the cached PointGrid of the mesh.
+ * The falloff f(v) = (1 - (d(v) / radius)^2)^2 is 1 at the point and vanishes smoothly at the radius, it is computed in
+ * parallel over the selected points.
+ *
+ * @param mesh The pointer to the vtkPolyData object.
+ * @param ptId The ID of the point.
+ * @param radius The radius of the region, in the units of the mesh.
+ *
+ * @return the falloff weights, 0 outside of the region.
+ */
+std::function<double(vtkIdType)> radiusFalloff(vtkPolyData* mesh, vtkIdType ptId, double radius);
+
+
+/**
+ * Builds the weight function of one of the weighting methods of the tools.
+ *
+ * @param method 0 simple harmonic, 1 laplacian diffusion with ringCount iterations, 2 solving the laplace equations,
+ * 3 spectral diffusion with ringCount iterations, 4 Euclidean radius falloff
+ * @param alpha diffusion parameter, only used by the diffusions
+ * @param nbModes number of modes of the spectral diffusion
+ * @param radius radius of the Euclidean region
+ */
+std::function<double(vtkIdType)> weightingFunction(int method, vtkPolyData* mesh, vtkIdType ptId, int ringCount,
+                                                   double alpha, int nbModes, double radius);
+
+/**
+ * Evaluates the weights of weightingFunction on every point of the mesh into a contiguous buffer, written from the
+ * values computed by the method rather than through its weight function: the points out of its support are 0.
+ *
+ * @param progress optional callback receiving the fraction of the iterations of the laplacian diffusion done
+ *
+ * @return the weight of every point.
+ */
+std::vector<float> weightingValues(int method, vtkPolyData* mesh, vtkIdType ptId, int ringCount, double alpha,
+                                   int nbModes, double radius, const std::function<void(double)>& progress = {});
+
+/**
+ * The points where the weights of weightingFunction may be non zero: the rings of the ring based methods, one more
+ * for the diffusion which spreads by a ring per iteration, the Euclidean region of the radius falloff, and every point
+ * for the spectral diffusion whose weights are global.
+ *
+ * @return the sorted ids of the points, allocated from the ScratchArena.
+ */
+std::pmr::vector<vtkIdType> weightingSupport(int method, vtkPolyData* mesh, vtkIdType ptId, int ringCount,
+                                             double radius);
+
+/**
+ * Predicts the peak bytes of the temporaries of simpleHarmonic, laplacianDiffusion and solveLaplace,
+ * including the topology of the mesh when it is not cached yet.
+ * The ring based predictions estimate the points of the rings from the mean valence of the mesh instead of walking
+ * them, they take constant time and can be made on every change of the parameters.
+ */
+std::size_t predictSimpleHarmonicBytes(vtkPolyData* mesh, long ringCount);
+std::size_t predictLaplacianDiffusionBytes(vtkPolyData* mesh);
+std::size_t predictSolveLaplaceBytes(vtkPolyData* mesh, int ringCount);
+std::size_t predictSpectralDiffusionBytes(vtkPolyData* mesh, int nbModes);
+std::size_t predictRadiusFalloffBytes(vtkPolyData* mesh);
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <vtkPolyData.h>
+
+#include <cstddef>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "ScratchArena.hpp"
+
+/**
+ * Records the peak of the temporaries of a compute call on the current thread.
+ * Scopes nest, the peak observed in an inner scope is also a peak of the enclosing scopes.
+ * The ScratchArena of the thread is open while a scope is alive, and reset when the outermost one ends.
+ */
+class MemoryScope {
+   public:
+    explicit MemoryScope(const char* name);
+    ~MemoryScope();
+    MemoryScope(MemoryScope&) = delete;
+    MemoryScope(MemoryScope&&) = delete;
+    MemoryScope& operator=(const MemoryScope&) = delete;
+    MemoryScope& operator=(MemoryScope&&) = delete;
+
+    /**
+     * Reports the bytes currently held by the temporaries of the innermost scope of this thread,
+     * does nothing outside of a scope.
+     */
+    static void observe(std::size_t bytes);
+
+    std::size_t peakBytes() const { return m_peakBytes; }
+
+   private:
+    const char* m_name;
+    std::size_t m_peakBytes = 0;
+    MemoryScope* m_parent;
+};
+
+struct OperationMemory {
+    std::string name;
+    std::size_t peakBytes = 0;
+    ArenaCounters arena;
+};
+
+/**
+ * @return the name and peak of the last outermost scope that ended, on any thread.
+ */
+OperationMemory lastOperationMemory();
+
+/**
+ * Sets the ceiling above which operations are refused, 0 disables it.
+ */
+void setMemoryCeiling(std::size_t bytes);
+std::size_t memoryCeiling();
+bool exceedsMemoryCeiling(std::size_t predictedBytes);
+
+/**
+ * @return the bytes held by the VTK arrays of the mesh.
+ */
+std::size_t meshArraysBytes(vtkPolyData* mesh);
+
+/**
+ * @return the bytes held by the caches derived from the mesh, 0 if none were built.
+ */
+std::size_t meshCachesBytes(vtkPolyData* mesh);
+
+template <typename T, typename A>
+std::size_t containerBytes(const std::vector<T, A>& v) {
+    return v.capacity() * sizeof(T);
+}
+
+template <typename K, typename V, typename H, typename E, typename A>
+std::size_t containerBytes(const std::unordered_map<K, V, H, E, A>& m) {
+    // one node per element holding the pair, the next pointer and the cached hash, plus the bucket array
+    return m.size() * (sizeof(std::pair<const K, V>) + 2 * sizeof(void*)) + m.bucket_count() * sizeof(void*);
+}
+
+template <typename K, typename V, typename C, typename A>
+std::size_t containerBytes(const std::map<K, V, C, A>& m) {
+    // red-black tree node, three pointers and the color
+    return m.size() * (sizeof(std::pair<const K, V>) + 4 * sizeof(void*));
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <vtkPolyData.h>
+#include <vtkSmartPointer.h>
+#include <vtkType.h>
+
+/**
+ * Returns a copy of the mesh with its points sorted along a Morton curve of their positions, and its polygons sorted
+ * by their smallest point id, so that the neighbors gathered by the kernels are close in memory.
+ * The original ids are kept in the "vtkOriginalPointIds" point array and the "vtkOriginalCellIds" cell array,
+ * reordering an already reordered mesh keeps the ids of the first mesh.
+ *
+ * @param mesh The vtkPolyData mesh, left unchanged.
+ *
+ * @return The reordered copy of the mesh.
+ */
+vtkSmartPointer<vtkPolyData> reorderForLocality(vtkPolyData* mesh);
+
+/**
+ * Undoes reorderForLocality, to save a mesh with the ids of the file it was loaded from.
+ * The vertex cells added since the reordering, to draw the point colors, are left out of the copy.
+ * Throws std::runtime_error when other cells were added or removed since the reordering.
+ *
+ * @return A copy of the mesh in the original order without the id arrays, or the mesh itself if it was not reordered.
+ */
+vtkSmartPointer<vtkPolyData> restoreOriginalOrder(vtkPolyData* mesh);
+
+/**
+ * @return the id of the point ptId in the file the mesh was loaded from.
+ */
+vtkIdType originalPointId(vtkPolyData* mesh, vtkIdType ptId);
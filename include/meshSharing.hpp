@@ -0,0 +1,68 @@
+#pragma once
+
+#include <vtkPolyData.h>
+#include <vtkSmartPointer.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+
+/**
+ * Hashes a buffer in parallel, by blocks combined in order, so that the hash does not depend on the threads.
+ */
+std::uint64_t hashBytes(const void* data, std::size_t size);
+
+/**
+ * @return the hash of the content of a file and of the loading options, equal for copies of the same file.
+ * Throws std::runtime_error when the file cannot be read.
+ */
+std::uint64_t meshKey(const std::filesystem::path& path, bool reorder);
+
+/**
+ * Returns a new mesh sharing the points, polygons and attribute arrays of a mesh loaded with the same key, as long as
+ * a mesh still uses them and they were not modified in place.
+ * Must be called from the main thread, which is the one modifying the meshes: the arrays found cannot start being
+ * modified before the new mesh holds them, and detachSharedPoints then sees them shared.
+ *
+ * @return the new mesh, nullptr when no mesh of this key is loaded.
+ */
+vtkSmartPointer<vtkPolyData> findSharedMesh(std::uint64_t key);
+
+/**
+ * The hashes of the points and the polygons of a mesh just loaded, under which shareMesh looks for identical arrays.
+ */
+struct MeshHashes {
+    std::uint64_t points = 0;
+    std::uint64_t polys = 0;
+};
+
+/**
+ * Hashes the points and the polygons of a mesh that no other thread modifies, such as a mesh just read, on any thread.
+ */
+MeshHashes hashMesh(vtkPolyData* mesh);
+
+/**
+ * Registers a mesh just loaded under its key. Its points and polygons are first replaced by the identical arrays of
+ * the meshes already loaded, if any, so that variants of a file sharing their positions or their faces share them in
+ * memory, and share the topology cached for the polygons.
+ * Only the meshes made of polygons are shared, the others are returned as they are.
+ * Must be called from the main thread, see findSharedMesh.
+ *
+ * @param hashes the hashes of the mesh, from hashMesh
+ *
+ * @return the mesh.
+ */
+vtkSmartPointer<vtkPolyData> shareMesh(std::uint64_t key, vtkSmartPointer<vtkPolyData> mesh,
+                                       const MeshHashes& hashes);
+vtkSmartPointer<vtkPolyData> shareMesh(std::uint64_t key, vtkSmartPointer<vtkPolyData> mesh);
+
+/**
+ * @return true when the points of the mesh are also used by another mesh.
+ */
+bool sharesPoints(vtkPolyData* mesh);
+
+/**
+ * Copy on write of the shared points, gives the mesh its own copy of its points if another mesh uses them, so that they
+ * can be modified in place. Called by the deformations before they move the points.
+ */
+void detachSharedPoints(vtkPolyData* mesh);
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <span>
+#include <stop_token>
+
+/**
+ * Header of the raw mesh files used by the out-of-core operations, followed by
+ * double points[3 * nbPoints], int64 offsets[nbFaces + 1] and int64 connectivity[nbConnectivity],
+ * so that every section can be memory mapped in place.
+ */
+struct RawMeshHeader {
+    char magic[8];
+    std::uint64_t nbPoints;
+    std::uint64_t nbFaces;
+    std::uint64_t nbConnectivity;
+
+    std::size_t pointsOffset() const { return sizeof(RawMeshHeader); }
+    std::size_t offsetsOffset() const { return pointsOffset() + 3 * nbPoints * sizeof(double); }
+    std::size_t connectivityOffset() const { return offsetsOffset() + (nbFaces + 1) * sizeof(std::int64_t); }
+    std::size_t fileSize() const { return connectivityOffset() + nbConnectivity * sizeof(std::int64_t); }
+};
+
+/**
+ * Parses a Wavefront OBJ file line by line, handing its positions and its faces of at least three points to the
+ * callbacks in the order of the file, the indices of the faces starting at 0. The other elements are skipped.
+ * Throws std::runtime_error when the file cannot be opened.
+ *
+ * @param progress optional callback receiving the fraction of the bytes of the file parsed, once per block of lines
+ * @param stopToken the parse stops before the next block of lines when a stop is requested
+ *
+ * @return false when the parse was stopped before the end of the file.
+ */
+bool parseObj(const std::filesystem::path& objPath, const std::function<void(const double*)>& point,
+              const std::function<void(std::span<const std::int64_t>)>& face,
+              const std::function<void(double)>& progress = {}, std::stop_token stopToken = {});
+
+/**
+ * Converts a Wavefront OBJ file to a raw mesh file line by line, without holding the mesh in memory.
+ * Only the positions and the faces are kept.
+ */
+void convertObjToRaw(const std::filesystem::path& objPath, const std::filesystem::path& rawPath);
+
+/**
+ * Writes a raw mesh file as a Wavefront OBJ file, without holding the mesh in memory.
+ */
+void convertRawToObj(const std::filesystem::path& rawPath, const std::filesystem::path& objPath);
+
+/**
+ * Same smoothing as laplacianSmoothing, on a raw mesh file that does not need to fit in memory.
+ *
+ * The points are partitioned in spatial chunks of at most chunkPoints points, and every chunk keeps the adjacency of
+ * its points on disk, their one-ring halo included, the adjacencies of all the chunks are mapped once for the whole
+ * run. Every iteration processes the chunks in parallel, each copying the positions of the previous iteration of its
+ * points and of their halo from a memory mapped buffer into a local one, and writing the new positions of its own
+ * points in a second mapped buffer, the buffers are swapped between iterations.
+ * The memory used is bounded by the size of the chunks being processed, not by the size of the mesh.
+ * Throws std::runtime_error when a face of the file uses a point it does not have.
+ *
+ * @param inputPath The raw mesh to smooth, left unchanged.
+ * @param outputPath The smoothed raw mesh.
+ * @param numIterations The number of smoothing iterations.
+ * @param chunkPoints The number of points of a chunk.
+ * @param progress optional callback receiving the fraction of the work done
+ */
+void laplacianSmoothingOutOfCore(const std::filesystem::path& inputPath, const std::filesystem::path& outputPath,
+                                 int numIterations, std::size_t chunkPoints = 1 << 20,
+                                 const std::function<void(double)>& progress = {});
+
+/**
+ * Smooths an OBJ or raw mesh file into an OBJ or raw mesh file, converting through temporary raw files next to the
+ * output when needed.
+ */
+void smoothFileOutOfCore(const std::filesystem::path& inputPath, const std::filesystem::path& outputPath,
+                         int numIterations, std::size_t chunkPoints = 1 << 20,
+                         const std::function<void(double)>& progress = {});
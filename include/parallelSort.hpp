@@ -0,0 +1,91 @@
+#pragma once
+
+#include <vtkSMPTools.h>
+#include <vtkType.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Parallel least significant digit radix sort, stable.
+ * Every pass histograms the chunks of the input in parallel then scatters them in parallel.
+ *
+ * @param items The items to sort.
+ * @param key A function returning the unsigned integer key of an item.
+ * @param keyBits The number of significant bits of the keys.
+ */
+template <typename T, typename KeyFn>
+void parallelRadixSort(std::vector<T>& items, KeyFn key, int keyBits) {
+    constexpr int digitBits = 8;
+    constexpr std::size_t buckets = std::size_t{1} << digitBits;
+    const std::size_t n = items.size();
+    if (n < 2) return;
+
+    const std::size_t nbChunks =
+        std::clamp<std::size_t>(4 * vtkSMPTools::GetEstimatedNumberOfThreads(), 1, (n + buckets - 1) / buckets);
+    const std::size_t chunkSize = (n + nbChunks - 1) / nbChunks;
+    std::vector<T> buffer(n);
+    std::vector<std::size_t> histograms(nbChunks * buckets);
+
+    for (int shift = 0; shift < keyBits; shift += digitBits) {
+        auto digit = [&](const T& item) { return (static_cast<std::uint64_t>(key(item)) >> shift) & (buckets - 1); };
+        std::fill(histograms.begin(), histograms.end(), 0);
+        vtkSMPTools::For(0, nbChunks, 1, [&](vtkIdType begin, vtkIdType end) {
+            for (std::size_t c = begin; c < static_cast<std::size_t>(end); ++c) {
+                auto* histogram = &histograms[c * buckets];
+                for (auto i = c * chunkSize; i < std::min(n, (c + 1) * chunkSize); ++i) {
+                    ++histogram[digit(items[i])];
+                }
+            }
+        });
+        // exclusive scan, digit major so that each chunk writes after the previous chunks
+        std::size_t sum = 0;
+        for (std::size_t d = 0; d < buckets; ++d) {
+            for (std::size_t c = 0; c < nbChunks; ++c) {
+                auto count = histograms[c * buckets + d];
+                histograms[c * buckets + d] = sum;
+                sum += count;
+            }
+        }
+        vtkSMPTools::For(0, nbChunks, 1, [&](vtkIdType begin, vtkIdType end) {
+            for (std::size_t c = begin; c < static_cast<std::size_t>(end); ++c) {
+                auto* histogram = &histograms[c * buckets];
+                for (auto i = c * chunkSize; i < std::min(n, (c + 1) * chunkSize); ++i) {
+                    buffer[histogram[digit(items[i])]++] = items[i];
+                }
+            }
+        });
+        items.swap(buffer);
+    }
+}
+
+/**
+ * Computes the start of each range of a sorted sequence of keys in parallel.
+ *
+ * @param nbRanges The number of ranges, keys are in [0, nbRanges).
+ * @param size The number of keys.
+ * @param keyAt A function returning the i-th key of the sorted sequence.
+ *
+ * @return nbRanges + 1 offsets, the keys equal to r are in [offsets[r], offsets[r + 1]).
+ */
+template <typename KeyAtFn>
+std::vector<vtkIdType> parallelRangeOffsets(vtkIdType nbRanges, vtkIdType size, KeyAtFn keyAt) {
+    std::vector<vtkIdType> offsets(nbRanges + 1);
+    vtkSMPTools::For(0, nbRanges + 1, [&](vtkIdType begin, vtkIdType end) {
+        for (auto r = begin; r < end; ++r) {
+            vtkIdType lo = 0;
+            vtkIdType hi = size;
+            while (lo < hi) {
+                auto mid = lo + (hi - lo) / 2;
+                if (keyAt(mid) < r) {
+                    lo = mid + 1;
+                } else {
+                    hi = mid;
+                }
+            }
+            offsets[r] = lo;
+        }
+    });
+    return offsets;
+}
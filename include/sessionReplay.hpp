@@ -0,0 +1,11 @@
+#pragma once
+
+#include <filesystem>
+
+/**
+ * Replays a session recorded by SessionRecorder without opening a window, timing every stage of every operation,
+ * and prints a report of where the time went.
+ *
+ * @return the exit code, 0 on success
+ */
+int replaySession(const std::filesystem::path& logPath);
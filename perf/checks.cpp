@@ -0,0 +1,305 @@
+#include <vtkActor.h>
+#include <vtkCellArray.h>
+#include <vtkCellData.h>
+#include <vtkDataArray.h>
+#include <vtkIdList.h>
+#include <vtkNew.h>
+#include <vtkOBJReader.h>
+#include <vtkPointData.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+#include <vtkRenderWindow.h>
+#include <vtkRenderer.h>
+#include <vtkSmartPointer.h>
+#include <vtkType.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <span>
+#include <stop_token>
+#include <string>
+#include <vector>
+
+#include "MappedFile.hpp"
+#include "PartialUploadPolyDataMapper.hpp"
+#include "colorize.hpp"
+#include "deformations.hpp"
+#include "harmonicFn.hpp"
+#include "meshReorder.hpp"
+#include "outOfCore.hpp"
+#include "referenceMeshes.hpp"
+
+namespace {
+
+// same as the performance harness, the checks that render are skipped when there is no offscreen context
+constexpr int skipReturnCode = 77;
+
+/**
+ * Correctness check of an optimization, false with a message on std::cerr when it fails.
+ */
+struct Check {
+    std::string name;
+    std::function<bool(const std::filesystem::path&)> run;
+    bool renders = false;
+};
+
+vtkSmartPointer<vtkPolyData> readObj(const std::filesystem::path& path) {
+    vtkNew<vtkOBJReader> reader;
+    reader->SetFileName(path.string().c_str());
+    reader->Update();
+    return reader->GetOutput();
+}
+
+vtkSmartPointer<vtkPolyData> referenceSphere(const std::filesystem::path& directory) {
+    auto path = directory / "check-sphere.obj";
+    if (!std::filesystem::exists(path)) writeSphere(path, 40, 80);
+    return readObj(path);
+}
+
+bool sameValues(vtkDataArray* a, vtkDataArray* b) {
+    return a->GetDataType() == b->GetDataType() && a->GetNumberOfValues() == b->GetNumberOfValues() &&
+           std::memcmp(a->GetVoidPointer(0), b->GetVoidPointer(0),
+                       static_cast<std::size_t>(a->GetNumberOfValues()) * a->GetDataTypeSize()) == 0;
+}
+
+bool samePolys(vtkPolyData* a, vtkPolyData* b) {
+    if (a->GetNumberOfPolys() != b->GetNumberOfPolys()) return false;
+    vtkNew<vtkIdList> ids;
+    for (vtkIdType f = 0; f < a->GetNumberOfPolys(); ++f) {
+        vtkIdType nA, nB;
+        const vtkIdType* ptsA;
+        const vtkIdType* ptsB;
+        a->GetPolys()->GetCellAtId(f, nA, ptsA, ids);
+        std::vector<vtkIdType> face(ptsA, ptsA + nA);
+        b->GetPolys()->GetCellAtId(f, nB, ptsB, ids);
+        if (!std::equal(face.begin(), face.end(), ptsB, ptsB + nB)) return false;
+    }
+    return true;
+}
+
+bool reorderRestore(const std::filesystem::path& directory) {
+    auto mesh = referenceSphere(directory);
+    auto reordered = reorderForLocality(mesh);
+    if (sameValues(reordered->GetPoints()->GetData(), mesh->GetPoints()->GetData())) {
+        std::cerr << "the reordered points are in the order of the file\n";
+        return false;
+    }
+    auto restored = restoreOriginalOrder(reordered);
+    if (!sameValues(restored->GetPoints()->GetData(), mesh->GetPoints()->GetData())) {
+        std::cerr << "the restored points differ from the points of the file\n";
+        return false;
+    }
+    if (!samePolys(restored, mesh)) {
+        std::cerr << "the restored polygons differ from the polygons of the file\n";
+        return false;
+    }
+    if (restored->GetPointData()->GetNumberOfArrays() != mesh->GetPointData()->GetNumberOfArrays() ||
+        restored->GetCellData()->GetNumberOfArrays() != mesh->GetCellData()->GetNumberOfArrays()) {
+        std::cerr << "the restored mesh kept the original id arrays\n";
+        return false;
+    }
+    return true;
+}
+
+bool reorderedPartialUpload(const std::filesystem::path& directory) {
+    auto reordered = reorderForLocality(referenceSphere(directory));
+    const std::array<float, 3> color = {0.5f, 0.5f, 0.5f};
+    colorizeMesh(reordered, color.data());
+    vtkNew<PartialUploadPolyDataMapper> mapper;
+    mapper->SetInputData(reordered);
+    if (mapper->uploadsCellAttributes(reordered)) {
+        std::cerr << "the original cell ids of the reordered mesh prevent the partial upload\n";
+        return false;
+    }
+    mapper->SetScalarModeToUseCellFieldData();
+    mapper->SelectColorArray("vtkOriginalCellIds");
+    if (!mapper->uploadsCellAttributes(reordered)) {
+        std::cerr << "the cell scalars selected for the coloring are not seen as uploaded\n";
+        return false;
+    }
+    return true;
+}
+
+vtkSmartPointer<vtkRenderWindow> offscreenWindow() {
+    auto renWin = vtkSmartPointer<vtkRenderWindow>::New();
+    renWin->SetOffScreenRendering(true);
+    renWin->SetSize(64, 64);
+    return renWin;
+}
+
+bool partialUploadRenders(const std::filesystem::path& directory) {
+    auto mesh = referenceSphere(directory);
+    vtkNew<PartialUploadPolyDataMapper> mapper;
+    mapper->SetInputData(mesh);
+    vtkNew<vtkActor> actor;
+    actor->SetMapper(mapper);
+    vtkNew<vtkRenderer> renderer;
+    renderer->AddActor(actor);
+    auto renWin = offscreenWindow();
+    renWin->AddRenderer(renderer);
+    renWin->Render();
+
+    // a deformation of the deform window, then the frame of the edit and the one after it
+    constexpr int rings = 4;
+    vtkIdType ptId = mesh->FindPoint(mesh->GetCenter());
+    auto ranges = weightedTranslate(mesh, ptId, 0.05, simpleHarmonic(mesh, ptId, rings),
+                                    weightingSupport(0, mesh, ptId, rings, 0.0));
+    for (auto range : ranges) mapper->addModifiedPoints(range.begin, range.end);
+    renWin->Render();
+    renWin->Render();
+    if (mapper->partialUploads() != 1 || mapper->fullUploads() != 1) {
+        std::cerr << "the deformation took " << mapper->partialUploads() << " partial and "
+                  << mapper->fullUploads() - 1 << " full uploads after the first render, instead of a single "
+                  << "partial upload\n";
+        return false;
+    }
+    return true;
+}
+
+vtkSmartPointer<vtkPolyData> readRaw(const std::filesystem::path& path) {
+    MappedFile file(path, MappedFile::Mode::Read);
+    RawMeshHeader header;
+    std::memcpy(&header, file.at<std::byte>(0), sizeof(RawMeshHeader));
+    const double* positions = file.at<double>(header.pointsOffset());
+    const std::int64_t* offsets = file.at<std::int64_t>(header.offsetsOffset());
+    const std::int64_t* connectivity = file.at<std::int64_t>(header.connectivityOffset());
+    vtkNew<vtkPoints> points;
+    points->SetDataTypeToDouble();
+    points->SetNumberOfPoints(static_cast<vtkIdType>(header.nbPoints));
+    for (std::uint64_t i = 0; i < header.nbPoints; ++i) points->SetPoint(i, positions + 3 * i);
+    vtkNew<vtkCellArray> polys;
+    std::vector<vtkIdType> face;
+    for (std::uint64_t f = 0; f < header.nbFaces; ++f) {
+        face.assign(connectivity + offsets[f], connectivity + offsets[f + 1]);
+        polys->InsertNextCell(static_cast<vtkIdType>(face.size()), face.data());
+    }
+    auto mesh = vtkSmartPointer<vtkPolyData>::New();
+    mesh->SetPoints(points);
+    mesh->SetPolys(polys);
+    return mesh;
+}
+
+bool outOfCoreSmoothing(const std::filesystem::path& directory) {
+    constexpr int iterations = 5;
+    // a grid with a far away point, all of its points fall in a single cell of the partition, which must be split
+    auto densePath = directory / "check-dense-grid.obj";
+    writeGrid(densePath, 40);
+    std::ofstream(densePath, std::ios::app) << "v 1000 1000 0\n";
+    auto spherePath = directory / "check-sphere.obj";
+    if (!std::filesystem::exists(spherePath)) writeSphere(spherePath, 40, 80);
+
+    for (const auto& objPath : {densePath, spherePath}) {
+        for (std::size_t chunkPoints : {std::size_t{100}, std::size_t{1} << 20}) {
+            auto rawPath = directory / "check-smoothing.raw";
+            auto smoothedPath = directory / "check-smoothing-out.raw";
+            convertObjToRaw(objPath, rawPath);
+            laplacianSmoothingOutOfCore(rawPath, smoothedPath, iterations, chunkPoints);
+            auto mesh = readRaw(rawPath);
+            laplacianSmoothing(mesh, iterations);
+            auto smoothed = readRaw(smoothedPath);
+            double error = 0.0;
+            for (vtkIdType i = 0; i < mesh->GetNumberOfPoints(); ++i) {
+                double expected[3], actual[3];
+                mesh->GetPoint(i, expected);
+                smoothed->GetPoint(i, actual);
+                for (int k = 0; k < 3; ++k) error = std::max(error, std::abs(expected[k] - actual[k]));
+            }
+            if (error > 1e-12) {
+                std::cerr << objPath.filename().string() << " in chunks of " << chunkPoints
+                          << " points differs from laplacianSmoothing by " << error << "\n";
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+bool objParse(const std::filesystem::path& directory) {
+    // more lines than a block of the parser, so that it reports progress and checks the stop while parsing
+    auto path = directory / "check-parse-grid.obj";
+    if (!std::filesystem::exists(path)) writeGrid(path, 400);
+    auto reference = readObj(path);
+    vtkIdType nbPoints = 0;
+    vtkIdType nbFaces = 0;
+    std::vector<double> fractions;
+    bool complete = parseObj(
+        path, [&](const double*) { ++nbPoints; }, [&](std::span<const std::int64_t>) { ++nbFaces; },
+        [&](double fraction) { fractions.push_back(fraction); });
+    if (!complete || nbPoints != reference->GetNumberOfPoints() || nbFaces != reference->GetNumberOfPolys()) {
+        std::cerr << "the parser read " << nbPoints << " points and " << nbFaces << " faces instead of "
+                  << reference->GetNumberOfPoints() << " and " << reference->GetNumberOfPolys() << "\n";
+        return false;
+    }
+    if (fractions.size() < 3 || !std::ranges::is_sorted(fractions) || fractions.back() != 1.0) {
+        std::cerr << "the parser reported " << fractions.size() << " fractions, not growing up to 1\n";
+        return false;
+    }
+
+    std::stop_source stop;
+    vtkIdType pointsBeforeStop = 0;
+    complete = parseObj(
+        path, [&](const double*) { ++pointsBeforeStop; }, [](std::span<const std::int64_t>) {},
+        [&](double fraction) {
+            if (fraction > 0.0) stop.request_stop();
+        },
+        stop.get_token());
+    if (complete || pointsBeforeStop >= nbPoints) {
+        std::cerr << "the parser did not stop when requested\n";
+        return false;
+    }
+    return true;
+}
+
+const std::vector<Check> checks = {
+    {"reorder-restore", reorderRestore},
+    {"reordered-partial-upload", reorderedPartialUpload},
+    {"partial-upload-renders", partialUploadRenders, true},
+    {"out-of-core-smoothing", outOfCoreSmoothing},
+    {"obj-parse", objParse},
+};
+
+void usage() {
+    std::cerr << "usage: geo_checks <check> [--output dir]\n"
+                 "       geo_checks --list\n";
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    std::string name;
+    std::filesystem::path output = "results";
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--list") {
+            for (const auto& check : checks) std::cout << check.name << "\n";
+            return 0;
+        } else if (arg == "--output" && i + 1 < argc) {
+            output = argv[++i];
+        } else if (name.empty() && !arg.starts_with("--")) {
+            name = arg;
+        } else {
+            usage();
+            return 2;
+        }
+    }
+    for (const auto& check : checks) {
+        if (check.name != name) continue;
+        if (check.renders && !offscreenWindow()->SupportsOpenGL()) {
+            std::cout << name << ": skipped, no OpenGL context without a display\n";
+            return skipReturnCode;
+        }
+        std::filesystem::create_directories(output);
+        bool passed = check.run(output);
+        std::cout << name << (passed ? ": passed\n" : ": failed\n");
+        return passed ? 0 : 1;
+    }
+    usage();
+    return 2;
+}
@@ -0,0 +1,294 @@
+#include <vtkNew.h>
+#include <vtkOBJReader.h>
+#include <vtkPolyData.h>
+#include <vtkSmartPointer.h>
+#include <vtkType.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif  // _WIN32
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "deformations.hpp"
+#include "harmonicFn.hpp"
+#include "perfJson.hpp"
+#include "referenceMeshes.hpp"
+
+namespace {
+
+// CTest reports the scenarios without baseline as skipped
+constexpr int skipReturnCode = 77;
+
+struct Options {
+    std::string scenario;
+    std::filesystem::path baselines = "baselines";
+    std::filesystem::path output = "results";
+    double tolerance = 0.25;
+    double slackMs = 1.0;
+    double weightTolerance = 1e-9;
+    int repeats = 5;
+    bool record = false;
+};
+
+struct ReferenceMesh {
+    std::string name;
+    std::function<void(const std::filesystem::path&)> write;
+    std::array<double, 3> seed;
+};
+
+struct WeightingMethod {
+    std::string name;
+    int method;  // the weighting method of weightingFunction
+    int ringCount;
+    double alpha;
+};
+
+const std::vector<ReferenceMesh> referenceMeshes = {
+    {"grid", [](const auto& path) { writeGrid(path, 200); }, {0.5, 0.5, 0.0}},
+    {"sphere", [](const auto& path) { writeSphere(path, 150, 300); }, {0.0, 0.0, 1.0}},
+};
+
+const std::vector<WeightingMethod> weightingMethods = {
+    {"simpleHarmonic", 0, 8, 0.0},
+    {"laplacianDiffusion", 1, 30, 0.25},
+    {"solveLaplace", 2, 8, 0.0},
+};
+
+constexpr double translateDistance = 0.05;
+constexpr int smoothingIterations = 5;
+const std::array<const char*, 5> stages = {"load", "pick", "weight", "translate", "smooth"};
+
+double peakRssKiB() {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters));
+    return counters.PeakWorkingSetSize / 1024.0;
+#else
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return static_cast<double>(usage.ru_maxrss);
+#endif  // _WIN32
+}
+
+double percentile(std::vector<double> values, double p) {
+    std::ranges::sort(values);
+    auto rank = static_cast<std::size_t>(std::ceil(p * values.size()));
+    return values[std::clamp<std::size_t>(rank, 1, values.size()) - 1];
+}
+
+/**
+ * Runs the load, pick, weight, translate and smooth pipeline driven by Tools, options.repeats times.
+ */
+JsonValue runScenario(const ReferenceMesh& reference, const WeightingMethod& method, const Options& options) {
+    auto objPath = options.output / (reference.name + ".obj");
+    if (!std::filesystem::exists(objPath)) reference.write(objPath);
+
+    std::vector<std::vector<double>> timings(stages.size());
+    auto weights = JsonValue::makeArray();
+    for (int r = 0; r < options.repeats; ++r) {
+        std::size_t stage = 0;
+        auto start = std::chrono::steady_clock::now();
+        auto lap = [&] {
+            auto now = std::chrono::steady_clock::now();
+            timings[stage++].push_back(std::chrono::duration<double, std::milli>(now - start).count());
+            start = now;
+        };
+
+        vtkNew<vtkOBJReader> reader;
+        reader->SetFileName(objPath.string().c_str());
+        reader->Update();
+        vtkSmartPointer<vtkPolyData> mesh = reader->GetOutput();
+        lap();
+
+        // headless pick, the vertex closest to the fixed seed position
+        auto seed = reference.seed;
+        vtkIdType ptId = mesh->FindPoint(seed.data());
+        lap();
+
+        auto weight = weightingFunction(method.method, mesh, ptId, method.ringCount, method.alpha, 0, 0.0);
+        lap();
+
+        if (r == 0) {
+            for (vtkIdType p = 0; p < mesh->GetNumberOfPoints(); ++p) {
+                if (double w = weight(p); w != 0.0) {
+                    auto entry = JsonValue::makeArray();
+                    entry.array = {JsonValue::makeNumber(p), JsonValue::makeNumber(w)};
+                    weights.array.push_back(std::move(entry));
+                }
+            }
+            start = std::chrono::steady_clock::now();
+        }
+
+        weightedTranslate(mesh, ptId, translateDistance, weight,
+                          weightingSupport(method.method, mesh, ptId, method.ringCount, 0.0));
+        lap();
+
+        laplacianSmoothing(mesh, smoothingIterations);
+        lap();
+    }
+
+    auto result = JsonValue::makeObject();
+    result.set("scenario", JsonValue::makeString(reference.name + "-" + method.name));
+    result.set("repeats", JsonValue::makeNumber(options.repeats));
+    auto latencies = JsonValue::makeObject();
+    for (std::size_t s = 0; s < stages.size(); ++s) {
+        auto percentiles = JsonValue::makeObject();
+        percentiles.set("p50", JsonValue::makeNumber(percentile(timings[s], 0.5)));
+        percentiles.set("p90", JsonValue::makeNumber(percentile(timings[s], 0.9)));
+        percentiles.set("max", JsonValue::makeNumber(percentile(timings[s], 1.0)));
+        latencies.set(stages[s], std::move(percentiles));
+    }
+    result.set("latency_ms", std::move(latencies));
+    result.set("peak_rss_kib", JsonValue::makeNumber(peakRssKiB()));
+    result.set("weights", std::move(weights));
+    return result;
+}
+
+/**
+ * @return the number of regressions of the result against the baseline.
+ */
+int compare(const JsonValue& result, const JsonValue& baseline, const Options& options) {
+    int failures = 0;
+    auto exceeds = [&](double current, double base, double slack) {
+        return current > base * (1.0 + options.tolerance) && current - base > slack;
+    };
+
+    if (auto baseLatencies = baseline.find("latency_ms")) {
+        const auto& latencies = *result.find("latency_ms");
+        for (std::size_t s = 0; s < baseLatencies->keys.size(); ++s) {
+            const auto& stage = baseLatencies->keys[s];
+            for (auto p : {"p50", "p90"}) {
+                auto base = baseLatencies->values[s].find(p);
+                auto current = latencies.find(stage) ? latencies.find(stage)->find(p) : nullptr;
+                if (base && current && exceeds(current->number, base->number, options.slackMs)) {
+                    std::cerr << std::format("{} {}: {:.3f} ms, baseline {:.3f} ms\n", stage, p, current->number,
+                                             base->number);
+                    ++failures;
+                }
+            }
+        }
+    }
+
+    if (auto base = baseline.find("peak_rss_kib")) {
+        auto current = result.find("peak_rss_kib")->number;
+        if (exceeds(current, base->number, 0.0)) {
+            std::cerr << std::format("peak RSS: {:.0f} KiB, baseline {:.0f} KiB\n", current, base->number);
+            ++failures;
+        }
+    }
+
+    if (auto base = baseline.find("weights")) {
+        // the fields are compared point by point, a point missing from one of them has a zero weight there, so that
+        // the round off left by a solver on the points it fixes to zero does not change the set of points
+        std::map<vtkIdType, std::pair<double, double>> fields;
+        for (const auto& entry : base->array) {
+            fields[static_cast<vtkIdType>(entry.array[0].number)].second = entry.array[1].number;
+        }
+        for (const auto& entry : result.find("weights")->array) {
+            fields[static_cast<vtkIdType>(entry.array[0].number)].first = entry.array[1].number;
+        }
+        for (const auto& [id, values] : fields) {
+            auto [value, golden] = values;
+            if (std::abs(value - golden) > options.weightTolerance * std::max(1.0, std::abs(golden))) {
+                std::cerr << std::format("weights: point {} is {}, golden value {}\n", id, value, golden);
+                ++failures;
+                break;
+            }
+        }
+    }
+    return failures;
+}
+
+void usage() {
+    std::cerr << "usage: geo_perf --scenario <mesh>-<method> [--baselines dir] [--output dir] [--repeats n]\n"
+                 "                [--tolerance fraction] [--slack-ms ms] [--weight-tolerance eps] [--record]\n"
+                 "       geo_perf --list\n";
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto next = [&]() -> std::string { return i + 1 < argc ? argv[++i] : ""; };
+        if (arg == "--scenario") {
+            options.scenario = next();
+        } else if (arg == "--baselines") {
+            options.baselines = next();
+        } else if (arg == "--output") {
+            options.output = next();
+        } else if (arg == "--repeats") {
+            options.repeats = std::max(1, std::stoi(next()));
+        } else if (arg == "--tolerance") {
+            options.tolerance = std::stod(next());
+        } else if (arg == "--slack-ms") {
+            options.slackMs = std::stod(next());
+        } else if (arg == "--weight-tolerance") {
+            options.weightTolerance = std::stod(next());
+        } else if (arg == "--record") {
+            options.record = true;
+        } else if (arg == "--list") {
+            for (const auto& reference : referenceMeshes) {
+                for (const auto& method : weightingMethods) std::cout << reference.name << "-" << method.name << "\n";
+            }
+            return 0;
+        } else {
+            usage();
+            return 2;
+        }
+    }
+
+    const ReferenceMesh* reference = nullptr;
+    const WeightingMethod* method = nullptr;
+    for (const auto& r : referenceMeshes) {
+        for (const auto& m : weightingMethods) {
+            if (options.scenario == r.name + "-" + m.name) {
+                reference = &r;
+                method = &m;
+            }
+        }
+    }
+    if (reference == nullptr) {
+        usage();
+        return 2;
+    }
+
+    std::filesystem::create_directories(options.output);
+    auto result = runScenario(*reference, *method, options);
+    std::ofstream(options.output / (options.scenario + ".json")) << result.dump() << "\n";
+
+    auto baselinePath = options.baselines / (options.scenario + ".json");
+    if (options.record) {
+        std::filesystem::create_directories(options.baselines);
+        std::ofstream(baselinePath) << result.dump() << "\n";
+        std::cout << "recorded " << baselinePath.string() << "\n";
+        return 0;
+    }
+    if (!std::filesystem::exists(baselinePath)) {
+        std::cout << "no baseline at " << baselinePath.string() << ", record one with --record\n";
+        return skipReturnCode;
+    }
+
+    std::stringstream baseline;
+    baseline << std::ifstream(baselinePath).rdbuf();
+    int failures = compare(result, JsonValue::parse(baseline.str()), options);
+    std::cout << std::format("{}: {} regression(s)\n", options.scenario, failures);
+    return failures == 0 ? 0 : 1;
+}
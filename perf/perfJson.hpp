@@ -0,0 +1,162 @@
+#pragma once
+
+#include <cctype>
+#include <cstdlib>
+#include <format>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * Minimal JSON value, enough to write and read back the results and baselines of the performance harness.
+ */
+struct JsonValue {
+    enum class Type { Null, Number, String, Array, Object };
+
+    Type type = Type::Null;
+    double number = 0.0;
+    std::string string;
+    std::vector<JsonValue> array;
+    std::vector<std::string> keys;
+    std::vector<JsonValue> values;
+
+    static JsonValue makeNumber(double n) {
+        JsonValue v;
+        v.type = Type::Number;
+        v.number = n;
+        return v;
+    }
+    static JsonValue makeString(std::string s) {
+        JsonValue v;
+        v.type = Type::String;
+        v.string = std::move(s);
+        return v;
+    }
+    static JsonValue makeArray() {
+        JsonValue v;
+        v.type = Type::Array;
+        return v;
+    }
+    static JsonValue makeObject() {
+        JsonValue v;
+        v.type = Type::Object;
+        return v;
+    }
+
+    JsonValue& set(const std::string& key, JsonValue value) {
+        for (std::size_t i = 0; i < keys.size(); ++i) {
+            if (keys[i] == key) return values[i] = std::move(value);
+        }
+        keys.push_back(key);
+        values.push_back(std::move(value));
+        return values.back();
+    }
+
+    const JsonValue* find(const std::string& key) const {
+        for (std::size_t i = 0; i < keys.size(); ++i) {
+            if (keys[i] == key) return &values[i];
+        }
+        return nullptr;
+    }
+
+    std::string dump(int indent = 0) const {
+        const std::string pad(indent + 2, ' ');
+        switch (type) {
+            case Type::Number:
+                return std::format("{}", number);
+            case Type::String:
+                return std::format("\"{}\"", string);
+            case Type::Array: {
+                // arrays of numbers stay on one line, the weight fields would be unreadable otherwise
+                std::string out = "[";
+                for (std::size_t i = 0; i < array.size(); ++i) {
+                    out += (i == 0 ? "" : ", ") + array[i].dump(indent);
+                }
+                return out + "]";
+            }
+            case Type::Object: {
+                std::string out = "{\n";
+                for (std::size_t i = 0; i < keys.size(); ++i) {
+                    out += std::format("{}\"{}\": {}{}\n", pad, keys[i], values[i].dump(indent + 2),
+                                       i + 1 < keys.size() ? "," : "");
+                }
+                return out + std::string(indent, ' ') + "}";
+            }
+            default:
+                return "null";
+        }
+    }
+
+    static JsonValue parse(std::string_view text) {
+        std::size_t pos = 0;
+        auto value = parseValue(text, pos);
+        skipSpaces(text, pos);
+        if (pos != text.size()) throw std::runtime_error("trailing characters in JSON");
+        return value;
+    }
+
+   private:
+    static void skipSpaces(std::string_view text, std::size_t& pos) {
+        while (pos < text.size() && std::isspace(static_cast<unsigned char>(text[pos]))) ++pos;
+    }
+
+    static void expect(std::string_view text, std::size_t& pos, char c) {
+        skipSpaces(text, pos);
+        if (pos >= text.size() || text[pos] != c) throw std::runtime_error(std::format("expected '{}' in JSON", c));
+        ++pos;
+    }
+
+    static std::string parseString(std::string_view text, std::size_t& pos) {
+        expect(text, pos, '"');
+        std::string out;
+        while (pos < text.size() && text[pos] != '"') {
+            if (text[pos] == '\\' && pos + 1 < text.size()) ++pos;
+            out += text[pos++];
+        }
+        expect(text, pos, '"');
+        return out;
+    }
+
+    static JsonValue parseValue(std::string_view text, std::size_t& pos) {
+        skipSpaces(text, pos);
+        if (pos >= text.size()) throw std::runtime_error("unexpected end of JSON");
+        if (text[pos] == '{') {
+            auto object = makeObject();
+            ++pos;
+            skipSpaces(text, pos);
+            if (pos < text.size() && text[pos] == '}') return ++pos, object;
+            do {
+                auto key = parseString(text, pos);
+                expect(text, pos, ':');
+                object.set(key, parseValue(text, pos));
+                skipSpaces(text, pos);
+            } while (pos < text.size() && text[pos] == ',' && ++pos);
+            expect(text, pos, '}');
+            return object;
+        }
+        if (text[pos] == '[') {
+            auto array = makeArray();
+            ++pos;
+            skipSpaces(text, pos);
+            if (pos < text.size() && text[pos] == ']') return ++pos, array;
+            do {
+                array.array.push_back(parseValue(text, pos));
+                skipSpaces(text, pos);
+            } while (pos < text.size() && text[pos] == ',' && ++pos);
+            expect(text, pos, ']');
+            return array;
+        }
+        if (text[pos] == '"') return makeString(parseString(text, pos));
+        if (text.substr(pos, 4) == "null") {
+            pos += 4;
+            return {};
+        }
+        std::string number(text.substr(pos, text.find_first_of(",]} \n\r\t", pos) - pos));
+        char* end = nullptr;
+        double n = std::strtod(number.c_str(), &end);
+        if (end == number.c_str()) throw std::runtime_error("invalid JSON value");
+        pos += end - number.c_str();
+        return makeNumber(n);
+    }
+};
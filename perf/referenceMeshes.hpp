@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <numbers>
+
+// deterministic noise, the reference meshes must be identical on every machine
+inline double noise(std::uint64_t i) {
+    i ^= i >> 33;
+    i *= 0xff51afd7ed558ccdULL;
+    i ^= i >> 33;
+    i *= 0xc4ceb9fe1a85ec53ULL;
+    i ^= i >> 33;
+    return static_cast<double>(i >> 11) / static_cast<double>(std::uint64_t{1} << 53) - 0.5;
+}
+
+/**
+ * Writes a n x n grid of the unit square as an OBJ file, with a small deterministic noise along z.
+ */
+inline void writeGrid(const std::filesystem::path& path, int n) {
+    std::ofstream out(path);
+    for (int j = 0; j < n; ++j) {
+        for (int i = 0; i < n; ++i) {
+            out << std::format("v {} {} {}\n", double(i) / (n - 1), double(j) / (n - 1), 0.01 * noise(j * n + i));
+        }
+    }
+    for (int j = 0; j < n - 1; ++j) {
+        for (int i = 0; i < n - 1; ++i) {
+            int a = j * n + i + 1;  // obj indices start at 1
+            out << std::format("f {} {} {}\nf {} {} {}\n", a, a + 1, a + n + 1, a, a + n + 1, a + n);
+        }
+    }
+}
+
+/**
+ * Writes a UV sphere of radius about 1 as an OBJ file, with a small deterministic noise on the radius.
+ */
+inline void writeSphere(const std::filesystem::path& path, int rings, int segments) {
+    std::ofstream out(path);
+    out << "v 0 0 1\n";
+    for (int r = 1; r < rings; ++r) {
+        double theta = std::numbers::pi * r / rings;
+        for (int s = 0; s < segments; ++s) {
+            double phi = 2.0 * std::numbers::pi * s / segments;
+            double radius = 1.0 + 0.01 * noise(r * segments + s);
+            out << std::format("v {} {} {}\n", radius * std::sin(theta) * std::cos(phi),
+                               radius * std::sin(theta) * std::sin(phi), radius * std::cos(theta));
+        }
+    }
+    out << "v 0 0 -1\n";
+    auto ring = [&](int r, int s) { return 2 + (r - 1) * segments + (s % segments); };
+    int south = 2 + (rings - 1) * segments;
+    for (int s = 0; s < segments; ++s) {
+        out << std::format("f 1 {} {}\n", ring(1, s), ring(1, s + 1));
+        out << std::format("f {} {} {}\n", south, ring(rings - 1, s + 1), ring(rings - 1, s));
+    }
+    for (int r = 1; r < rings - 1; ++r) {
+        for (int s = 0; s < segments; ++s) {
+            out << std::format("f {} {} {}\nf {} {} {}\n", ring(r, s), ring(r + 1, s), ring(r + 1, s + 1), ring(r, s),
+                               ring(r + 1, s + 1), ring(r, s + 1));
+        }
+    }
+}
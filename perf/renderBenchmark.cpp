@@ -0,0 +1,320 @@
+#include <imgui.h>
+#include <imgui_impl_opengl3.h>
+#include <vtkActor.h>
+#include <vtkCamera.h>
+#include <vtkNew.h>
+#include <vtkOBJReader.h>
+#include <vtkPLYReader.h>
+#include <vtkPolyData.h>
+#include <vtkProperty.h>
+#include <vtkRenderWindow.h>
+#include <vtkRenderer.h>
+#include <vtkSmartPointer.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "MouseInteractorStylePP.hpp"
+#include "PartialUploadPolyDataMapper.hpp"
+#include "SessionLog.hpp"
+#include "Tools.hpp"
+#include "colorize.hpp"
+#include "harmonicFn.hpp"
+#include "perfJson.hpp"
+#include "referenceMeshes.hpp"
+
+namespace {
+
+// same as the performance harness, reported as skipped when there is no offscreen context
+constexpr int skipReturnCode = 77;
+
+struct Options {
+    std::vector<std::filesystem::path> meshes;
+    std::filesystem::path output = "results";
+    int frames = 120;
+    int width = 1600;
+    int height = 900;
+    bool overlay = true;
+};
+
+struct ReferenceMesh {
+    std::string name;
+    std::function<void(const std::filesystem::path&)> write;
+};
+
+// from the size of the interactive meshes to the size of the scans that stall the render loop
+const std::vector<ReferenceMesh> referenceMeshes = {
+    {"sphere", [](const auto& path) { writeSphere(path, 150, 300); }},
+    {"grid-200", [](const auto& path) { writeGrid(path, 200); }},
+    {"grid-500", [](const auto& path) { writeGrid(path, 500); }},
+    {"grid-1000", [](const auto& path) { writeGrid(path, 1000); }},
+};
+
+/**
+ * The actor properties toggled by the actor list of the tools, the colors being those of a weight field.
+ */
+struct PropertyVariant {
+    std::string name;
+    bool edges;
+    bool colors;
+    bool visible;
+};
+
+const std::vector<PropertyVariant> propertyVariants = {
+    {"surface", false, false, true},
+    {"edges", true, false, true},
+    {"colors", false, true, true},
+    {"colors-edges", true, true, true},
+    {"hidden", false, false, false},
+};
+
+constexpr int weightRings = 8;
+constexpr float colorNeutral[3] = {1.0f, 1.0f, 1.0f};
+constexpr float colorStart[3] = {1.0f, 0.0f, 0.0f};
+constexpr float colorEnd[3] = {0.0f, 0.0f, 1.0f};
+
+double percentile(std::vector<double> values, double p) {
+    std::ranges::sort(values);
+    auto rank = static_cast<std::size_t>(std::ceil(p * values.size()));
+    return values[std::clamp<std::size_t>(rank, 1, values.size()) - 1];
+}
+
+template <typename Reader>
+vtkSmartPointer<vtkPolyData> readMesh(const std::filesystem::path& path) {
+    vtkNew<Reader> reader;
+    reader->SetFileName(path.string().c_str());
+    reader->Update();
+    return reader->GetOutput();
+}
+
+/**
+ * The ImGui windows of the application drawn over the render, with the OpenGL backend only since there is no SDL
+ * window to read the events from.
+ */
+class Overlay {
+   public:
+    Overlay(vtkRenderWindow* renWin, vtkRenderer* renderer) : m_tools(renderer, m_picker, &m_picking, &m_recorder) {
+        IMGUI_CHECKVERSION();
+        ImGui::CreateContext();
+        ImGui::StyleColorsDark();
+        renWin->MakeCurrent();
+        m_initialized = ImGui_ImplOpenGL3_Init();
+        m_tools.enableActorListWindow();
+        m_tools.enableFunctionWindow();
+        m_tools.enableDeformWindow();
+    }
+    ~Overlay() {
+        if (m_initialized) ImGui_ImplOpenGL3_Shutdown();
+        ImGui::DestroyContext();
+    }
+    Overlay(Overlay&) = delete;
+    Overlay(Overlay&&) = delete;
+    Overlay& operator=(const Overlay&) = delete;
+    Overlay& operator=(Overlay&&) = delete;
+
+    bool available() const { return m_initialized; }
+
+    void draw(int width, int height) {
+        ImGuiIO& io = ImGui::GetIO();
+        io.DisplaySize = ImVec2(static_cast<float>(width), static_cast<float>(height));
+        io.DeltaTime = 1.0f / 60.0f;
+        ImGui_ImplOpenGL3_NewFrame();
+        ImGui::NewFrame();
+        m_tools.showWindows();
+        ImGui::Render();
+        ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+    }
+
+   private:
+    vtkNew<MouseInteractorStylePP> m_picker;
+    bool m_picking = false;
+    SessionRecorder m_recorder;
+    Tools m_tools;
+    bool m_initialized = false;
+};
+
+/**
+ * Renders a full orbit of the camera around the mesh, one frame per step.
+ *
+ * @return the duration of every frame in milliseconds, the first one includes the upload of the buffers.
+ */
+std::vector<double> orbit(vtkRenderWindow* renWin, vtkRenderer* renderer, Overlay* overlay, const Options& options) {
+    renderer->ResetCamera();
+    auto camera = renderer->GetActiveCamera();
+    camera->Elevation(20.0);
+    camera->OrthogonalizeViewUp();
+
+    std::vector<double> frames;
+    frames.reserve(options.frames + 1);
+    for (int i = 0; i <= options.frames; ++i) {
+        if (i > 0) camera->Azimuth(360.0 / options.frames);
+        renderer->ResetCameraClippingRange();
+        auto start = std::chrono::steady_clock::now();
+        renWin->Render();
+        if (overlay != nullptr) overlay->draw(options.width, options.height);
+        // the draw calls are asynchronous, a frame ends when the GPU is done with it
+        renWin->WaitForCompletion();
+        frames.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+    }
+    return frames;
+}
+
+JsonValue frameStatistics(const std::vector<double>& frames) {
+    std::vector<double> orbit(frames.begin() + 1, frames.end());
+    auto statistics = JsonValue::makeObject();
+    statistics.set("first", JsonValue::makeNumber(frames.front()));
+    statistics.set("p50", JsonValue::makeNumber(percentile(orbit, 0.5)));
+    statistics.set("p90", JsonValue::makeNumber(percentile(orbit, 0.9)));
+    statistics.set("p99", JsonValue::makeNumber(percentile(orbit, 0.99)));
+    statistics.set("max", JsonValue::makeNumber(percentile(orbit, 1.0)));
+    return statistics;
+}
+
+/**
+ * Renders the orbits of every property variant of a mesh, with and without the overlay.
+ */
+JsonValue benchmarkMesh(const std::string& name, vtkPolyData* mesh, vtkRenderWindow* renWin, vtkRenderer* renderer,
+                        Overlay& overlay, const Options& options) {
+    // the colored copy is the mesh as the visualization window leaves it, vertex cells included
+    vtkNew<vtkPolyData> colored;
+    colored->DeepCopy(mesh);
+    vtkIdType ptId = colored->FindPoint(colored->GetCenter());
+    colorizeWeights(colored, ptId, weightingValues(0, colored, ptId, weightRings, 0.0, 0, 0.0), colorNeutral,
+                    colorStart, colorEnd);
+
+    vtkNew<PartialUploadPolyDataMapper> mapper;
+    vtkNew<vtkActor> actor;
+    actor->SetMapper(mapper);
+    actor->SetObjectName(name);
+    renderer->AddActor(actor);
+
+    auto result = JsonValue::makeObject();
+    result.set("mesh", JsonValue::makeString(name));
+    result.set("points", JsonValue::makeNumber(mesh->GetNumberOfPoints()));
+    result.set("faces", JsonValue::makeNumber(mesh->GetNumberOfPolys()));
+    result.set("window", JsonValue::makeString(renWin->GetClassName()));
+    result.set("width", JsonValue::makeNumber(options.width));
+    result.set("height", JsonValue::makeNumber(options.height));
+    result.set("frames", JsonValue::makeNumber(options.frames));
+    auto variants = JsonValue::makeObject();
+    for (const auto& variant : propertyVariants) {
+        mapper->SetInputData(variant.colors ? colored.Get() : mesh);
+        actor->GetProperty()->SetEdgeVisibility(variant.edges);
+        actor->SetVisibility(variant.visible);
+
+        auto timings = JsonValue::makeObject();
+        for (bool withOverlay : {false, true}) {
+            if (withOverlay && !(options.overlay && overlay.available())) continue;
+            auto frames = orbit(renWin, renderer, withOverlay ? &overlay : nullptr, options);
+            auto statistics = frameStatistics(frames);
+            std::cout << std::format("{:<12} {:>10} {:<14} {:<8} {:>10.3f} {:>10.3f} {:>10.3f} {:>10.3f} {:>10.3f}\n",
+                                     name, mesh->GetNumberOfPoints(), variant.name, withOverlay ? "imgui" : "none",
+                                     statistics.find("first")->number, statistics.find("p50")->number,
+                                     statistics.find("p90")->number, statistics.find("p99")->number,
+                                     statistics.find("max")->number);
+            timings.set(withOverlay ? "overlay" : "no_overlay", std::move(statistics));
+        }
+        variants.set(variant.name, std::move(timings));
+    }
+    result.set("frame_ms", std::move(variants));
+
+    renderer->RemoveActor(actor);
+    return result;
+}
+
+void usage() {
+    std::cerr << "usage: geo_render_bench [--mesh file.obj|file.ply]... [--output dir] [--frames n] [--size WxH]\n"
+                 "                        [--no-overlay]\n"
+                 "Without --mesh, the reference meshes are generated in the output directory.\n";
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto next = [&]() -> std::string { return i + 1 < argc ? argv[++i] : ""; };
+        if (arg == "--mesh") {
+            options.meshes.emplace_back(next());
+        } else if (arg == "--output") {
+            options.output = next();
+        } else if (arg == "--frames") {
+            options.frames = std::max(1, std::stoi(next()));
+        } else if (arg == "--size") {
+            auto size = next();
+            auto x = size.find('x');
+            if (x == std::string::npos) {
+                usage();
+                return 2;
+            }
+            options.width = std::max(1, std::stoi(size.substr(0, x)));
+            options.height = std::max(1, std::stoi(size.substr(x + 1)));
+        } else if (arg == "--no-overlay") {
+            options.overlay = false;
+        } else {
+            usage();
+            return 2;
+        }
+    }
+    std::filesystem::create_directories(options.output);
+
+    // the render window of the factory, an EGL or OSMesa window when VTK is built for offscreen rendering
+    vtkNew<vtkRenderWindow> renWin;
+    renWin->SetOffScreenRendering(true);
+    renWin->SetSize(options.width, options.height);
+    vtkNew<vtkRenderer> renderer;
+    renderer->SetBackground(0.2, 0.2, 0.2);
+    renWin->AddRenderer(renderer);
+    if (!renWin->SupportsOpenGL()) {
+        std::cout << std::format("{} cannot create an OpenGL context, build VTK with EGL or OSMesa to render "
+                                 "without a display\n",
+                                 renWin->GetClassName());
+        return skipReturnCode;
+    }
+    renWin->Render();
+
+    Overlay overlay(renWin, renderer);
+    if (options.overlay && !overlay.available()) {
+        std::cerr << "ImGui cannot load OpenGL from the offscreen context, the overlay is not measured\n";
+    }
+
+    std::cout << std::format("{}, {}x{}, {} frames per orbit, frame times in ms\n", renWin->GetClassName(),
+                             options.width, options.height, options.frames);
+    std::cout << std::format("{:<12} {:>10} {:<14} {:<8} {:>10} {:>10} {:>10} {:>10} {:>10}\n", "mesh", "points",
+                             "properties", "overlay", "first", "p50", "p90", "p99", "max");
+
+    std::vector<std::pair<std::string, std::filesystem::path>> meshes;
+    if (options.meshes.empty()) {
+        for (const auto& reference : referenceMeshes) {
+            auto path = options.output / (reference.name + ".obj");
+            if (!std::filesystem::exists(path)) reference.write(path);
+            meshes.emplace_back(reference.name, path);
+        }
+    } else {
+        for (const auto& path : options.meshes) meshes.emplace_back(path.stem().string(), path);
+    }
+
+    for (const auto& [name, path] : meshes) {
+        vtkSmartPointer<vtkPolyData> mesh;
+        if (path.extension() == ".obj") {
+            mesh = readMesh<vtkOBJReader>(path);
+        } else if (path.extension() == ".ply") {
+            mesh = readMesh<vtkPLYReader>(path);
+        } else {
+            std::cerr << std::format("Error: unknown file type {}\n", path.string());
+            return 2;
+        }
+        auto result = benchmarkMesh(name, mesh, renWin, renderer, overlay, options);
+        std::ofstream(options.output / (name + "-render.json")) << result.dump() << "\n";
+    }
+    return 0;
+}
@@ -5,8 +5,13 @@
 #include <imgui_impl_opengl3.h>
 #include <imgui_impl_sdl2.h>
 #include <vtkCamera.h>
+#include <vtkMapper.h>
 #include <vtkPointPicker.h>
+#include <vtkPolyData.h>
 
+#include <chrono>
+#include <exception>
+#include <filesystem>
 #include <format>
 #include <iostream>
 #include <map>
@@ -48,7 +53,7 @@ Application::Application() {
         std::cerr << std::format("Error: {}\n", NFD_GetError());
     }
 
-    m_tools = std::make_unique<Tools>(m_renderer, m_pickingStyle, &m_picking);
+    m_tools = std::make_unique<Tools>(m_renderer, m_pickingStyle, &m_picking, &m_recorder);
 }
 
 Application::~Application() {
@@ -107,9 +112,84 @@ void Application::mainLoop() {
         SDL_GL_SwapWindow(m_window);
 
         m_tools->cleanup();
+        addLoadedMeshes();
     }  // render loop
 }
 
+void Application::toggleRecording() {
+    if (m_recorder.recording()) {
+        m_recorder.stop();
+        std::cout << "session recording stopped" << std::endl;
+        return;
+    }
+    auto seconds = std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::system_clock::now().time_since_epoch());
+    auto path = std::filesystem::absolute(std::format("session-{}.log", seconds.count()));
+    try {
+        m_recorder.start(path);
+        std::cout << std::format("recording session to {}, replay it with geo --replay", path.string()) << std::endl;
+    } catch (const std::exception &e) {
+        std::cerr << std::format("Error: {}\n", e.what());
+    }
+}
+
+void Application::saveSelectedMesh() {
+    auto actor = m_tools->selectedActor();
+    auto mesh = actor ? vtkPolyData::SafeDownCast(actor->GetMapper()->GetInput()) : nullptr;
+    if (mesh == nullptr) {
+        std::cout << "no mesh selected in the actors window" << std::endl;
+        return;
+    }
+    auto path = pickSaveFile(actor->GetObjectName());
+    if (!path.has_value()) return;
+    try {
+        saveMesh(*path, mesh);
+        std::cout << std::format("saved {}", path->string()) << std::endl;
+    } catch (const std::exception &e) {
+        std::cerr << std::format("Error: {}\n", e.what());
+    }
+}
+
+void Application::addLoadedMeshes() {
+    for (const auto &load : m_loader.takeFinished()) {
+        if (load->mesh) {
+            // recorded when the actor appears, so that the log keeps the order of the actors
+            m_recorder.recordOpen(load->path, load->reorder);
+            addMeshActor(load->path, load->mesh, m_renderer);
+            std::cout << std::format("loaded {} in {:.3f} s", load->path.filename().string(), load->seconds)
+                      << std::endl;
+        } else if (!load->error.empty()) {
+            std::cerr << std::format("Error: cannot load {}: {}\n", load->path.string(), load->error);
+        } else if (!load->stop.stop_requested()) {
+            std::cerr << std::format("Error: cannot load {}\n", load->path.string());
+        }
+    }
+}
+
+void Application::loadingSection() {
+    if (m_loader.loads().empty()) return;
+    if (ImGui::CollapsingHeader("Loading", ImGuiTreeNodeFlags_DefaultOpen)) {
+        ImGui::ProgressBar(static_cast<float>(m_loader.progress()), ImVec2(-1.0f, 0.0f), "Total");
+        for (const auto &load : m_loader.loads()) {
+            ImGui::PushID(load.get());
+            const bool cancelled = load->stop.stop_requested();
+            if (ImGui::Button(cancelled ? "Cancelling" : "Cancel") && !cancelled) {
+                load->stop.request_stop();
+            }
+            ImGui::SameLine();
+            const std::string label = std::format("{} ({:.1f} MiB)", load->path.filename().string(),
+                                                  static_cast<double>(load->bytes) / (1024.0 * 1024.0));
+            ImGui::ProgressBar(static_cast<float>(load->progress), ImVec2(-1.0f, 0.0f), label.c_str());
+            if (ImGui::IsItemHovered()) {
+                ImGui::SetTooltip("Reading the file fills the bar up to %.0f%%,\n"
+                                  "the rest is the triangulation and the reordering.",
+                                  100.0 * MeshLoader::readFraction);
+            }
+            ImGui::PopID();
+        }
+    }
+}
+
 void Application::mainWindow() {
     {
         static float f = 0.0f;
@@ -121,10 +201,8 @@ void Application::mainWindow() {
                 if (ImGui::MenuItem("Open..", "Ctrl+O")) { /* Do stuff */
                     auto path = pickModelFile();
                     if (path.has_value() && path->has_extension()) {
-                        if (path->extension() == ".obj") {
-                            openObjectFile(*path, m_renderer);
-                        } else if (path->extension() == ".ply") {
-                            openPLYFile(*path, m_renderer);
+                        if (path->extension() == ".obj" || path->extension() == ".ply") {
+                            m_loader.load(*path, m_reorderOnLoad);
                         } else {
                             std::cout << "unknown file type" << std::endl;
                         }
@@ -132,7 +210,12 @@ void Application::mainWindow() {
                         std::cout << "unable to detect extension" << std::endl;
                     }
                 }
-                if (ImGui::MenuItem("Save", "Ctrl+S")) { /* Do stuff */
+                ImGui::MenuItem("Reorder on load", nullptr, &m_reorderOnLoad);
+                if (ImGui::MenuItem("Record session", nullptr, m_recorder.recording())) {
+                    toggleRecording();
+                }
+                if (ImGui::MenuItem("Save", "Ctrl+S")) {
+                    saveSelectedMesh();
                 }
                 if (ImGui::MenuItem("Quit", "Ctrl+Q")) {
                     m_running = false;
@@ -209,6 +292,8 @@ void Application::mainWindow() {
             }
         }
 
+        loadingSection();
+
         //spacer
         ImGui::Dummy(ImVec2(0, 20));
         auto size = ImGui::GetIO().DisplaySize;
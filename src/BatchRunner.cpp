@@ -0,0 +1,69 @@
+#include "BatchRunner.hpp"
+
+#include <algorithm>
+#include <chrono>
+
+#include "memoryUsage.hpp"
+#include "meshSharing.hpp"
+
+BatchRunner::BatchRunner(unsigned nbThreads) : m_pool(nbThreads) {}
+
+void BatchRunner::run(const std::vector<std::pair<std::string, vtkPolyData*>>& meshes, Operation operation) {
+    // the queued tasks point to the jobs of the running batch
+    if (running()) return;
+    m_jobs.clear();
+    for (const auto& [name, mesh] : meshes) {
+        auto job = std::make_unique<Job>();
+        job->name = name;
+        job->target = mesh;
+        job->size = mesh->GetNumberOfPoints() + mesh->GetNumberOfCells();
+        m_jobs.push_back(std::move(job));
+    }
+    std::stable_sort(m_jobs.begin(), m_jobs.end(), [](const auto& l, const auto& r) { return l->size > r->size; });
+    m_operation = std::make_shared<Operation>(std::move(operation));
+    dispatch();
+}
+
+void BatchRunner::dispatch() {
+    auto inFlight = std::ranges::count_if(m_jobs, [](const auto& job) { return job->started && !job->done; });
+    for (auto& job : m_jobs) {
+        if (inFlight >= static_cast<std::ptrdiff_t>(m_pool.size())) break;
+        if (job->started) continue;
+        // the copy is made on the main thread, which is the only one modifying or rendering the target, and only
+        // when a worker is free so that only the running jobs hold one
+        job->work = vtkSmartPointer<vtkPolyData>::New();
+        job->work->DeepCopy(job->target);
+        job->started = true;
+        ++inFlight;
+        m_pool.submit([job = job.get(), operation = m_operation] {
+            auto start = std::chrono::steady_clock::now();
+            MemoryScope scope("batch");
+            (*operation)(job->work, [job](double progress) { job->progress = progress; });
+            job->seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            job->peakBytes = scope.peakBytes();
+            job->progress = 1.0;
+            job->done = true;
+        });
+    }
+}
+
+void BatchRunner::applyFinished() {
+    for (auto& job : m_jobs) {
+        if (job->done && !job->applied) {
+            // DeepCopy writes in the points of the target, which may be shared with other meshes
+            if (sharesPoints(job->target)) job->target->SetPoints(nullptr);
+            job->target->DeepCopy(job->work);
+            job->work = nullptr;
+            job->applied = true;
+        }
+    }
+    dispatch();
+}
+
+bool BatchRunner::processes(vtkPolyData* mesh) const {
+    return std::ranges::any_of(m_jobs, [mesh](const auto& job) { return !job->applied && job->target == mesh; });
+}
+
+bool BatchRunner::running() const {
+    return std::ranges::any_of(m_jobs, [](const auto& job) { return !job->done; });
+}
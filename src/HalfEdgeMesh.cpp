@@ -0,0 +1,229 @@
+#include "HalfEdgeMesh.hpp"
+
+#include <vtkCellArray.h>
+#include <vtkIdList.h>
+#include <vtkNew.h>
+#include <vtkSMPTools.h>
+#include <vtkTypeInt32Array.h>
+#include <vtkTypeInt64Array.h>
+#include <vtkWeakPointer.h>
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+
+#include "parallelSort.hpp"
+
+HalfEdgeMesh::HalfEdgeMesh(vtkPolyData* mesh) {
+    vtkCellArray* polys = mesh->GetPolys();
+    const vtkIdType nbVertices = mesh->GetNumberOfPoints();
+    const vtkIdType nbFaces = polys->GetNumberOfCells();
+    const int vertexBits = std::max(1, static_cast<int>(std::bit_width(static_cast<std::uint64_t>(nbVertices))));
+    // the size of every cell when they all have the same size, -1 otherwise
+    const vtkIdType arity = polys->IsHomogeneous();
+    m_faceArity = arity == 3 || arity == 4 ? arity : 0;
+
+    m_faceOffsets.resize(nbFaces + 1);
+    if (arity > 0) {
+        // fixed stride faces, the connectivity array is already the list of half-edge origins
+        const vtkIdType nbHalfEdges = nbFaces * arity;
+        m_heVertex.resize(nbHalfEdges);
+        m_heFace.resize(nbHalfEdges);
+        auto copyConnectivity = [&](const auto* connectivity) {
+            vtkSMPTools::For(0, nbHalfEdges, [&](vtkIdType begin, vtkIdType end) {
+                for (vtkIdType h = begin; h < end; ++h) {
+                    m_heVertex[h] = connectivity[h];
+                    m_heFace[h] = h / arity;
+                }
+            });
+        };
+        if (polys->IsStorage64Bit()) {
+            copyConnectivity(polys->GetConnectivityArray64()->GetPointer(0));
+        } else {
+            copyConnectivity(polys->GetConnectivityArray32()->GetPointer(0));
+        }
+        vtkSMPTools::For(0, nbFaces + 1, [&](vtkIdType begin, vtkIdType end) {
+            for (vtkIdType f = begin; f < end; ++f) m_faceOffsets[f] = f * arity;
+        });
+    } else {
+        // mixed faces, copied in parallel once their offsets are known
+        m_faceOffsets[0] = 0;
+        for (vtkIdType f = 0; f < nbFaces; ++f) {
+            m_faceOffsets[f + 1] = m_faceOffsets[f] + polys->GetCellSize(f);
+        }
+        m_heVertex.resize(m_faceOffsets[nbFaces]);
+        m_heFace.resize(m_faceOffsets[nbFaces]);
+        vtkSMPTools::For(0, nbFaces, [&](vtkIdType begin, vtkIdType end) {
+            vtkNew<vtkIdList> ids;
+            for (vtkIdType f = begin; f < end; ++f) {
+                vtkIdType npts;
+                const vtkIdType* pts;
+                polys->GetCellAtId(f, npts, pts, ids);
+                std::copy(pts, pts + npts, m_heVertex.begin() + m_faceOffsets[f]);
+                std::fill_n(m_heFace.begin() + m_faceOffsets[f], npts, f);
+            }
+        });
+    }
+    const vtkIdType nbHalfEdges = m_heVertex.size();
+
+    // vertex star, the outgoing half-edges sorted by origin
+    m_star.resize(nbHalfEdges);
+    vtkSMPTools::For(0, nbHalfEdges, [&](vtkIdType begin, vtkIdType end) {
+        for (vtkIdType h = begin; h < end; ++h) m_star[h] = h;
+    });
+    parallelRadixSort(m_star, [&](vtkIdType h) { return m_heVertex[h]; }, vertexBits);
+    m_starOffsets = parallelRangeOffsets(nbVertices, nbHalfEdges, [&](vtkIdType i) { return m_heVertex[m_star[i]]; });
+
+    dispatchArity([&](auto a) { buildEdges<decltype(a)::value>(vertexBits); });
+}
+
+template <int Arity>
+void HalfEdgeMesh::buildEdges(int vertexBits) {
+    const vtkIdType nbVertices = numberOfVertices();
+    const vtkIdType nbHalfEdges = numberOfHalfEdges();
+
+    // opposite half-edges and unique edges, found by sorting the half-edges by their undirected edge key
+    struct EdgeKey {
+        std::uint64_t key;
+        vtkIdType h;
+    };
+    std::vector<EdgeKey> keys(nbHalfEdges);
+    vtkSMPTools::For(0, nbHalfEdges, [&](vtkIdType begin, vtkIdType end) {
+        for (vtkIdType h = begin; h < end; ++h) {
+            std::uint64_t i = m_heVertex[h];
+            std::uint64_t j = m_heVertex[nextOf<Arity>(h)];
+            keys[h] = {(std::min(i, j) << vertexBits) | std::max(i, j), h};
+        }
+    });
+    parallelRadixSort(keys, [](const EdgeKey& k) { return k.key; }, 2 * vertexBits);
+
+    const std::uint64_t vertexMask = (std::uint64_t{1} << vertexBits) - 1;
+    const vtkIdType nbChunks = std::max<vtkIdType>(1, std::min<vtkIdType>(nbHalfEdges, 1024));
+    const vtkIdType chunkSize = (nbHalfEdges + nbChunks - 1) / nbChunks;
+    auto isFirst = [&](vtkIdType i) { return i == 0 || keys[i].key != keys[i - 1].key; };
+    std::vector<vtkIdType> chunkEdges(nbChunks + 1, 0);
+    m_heOpposite.resize(nbHalfEdges);
+    vtkSMPTools::For(0, nbChunks, 1, [&](vtkIdType begin, vtkIdType end) {
+        for (auto c = begin; c < end; ++c) {
+            for (auto i = c * chunkSize; i < std::min(nbHalfEdges, (c + 1) * chunkSize); ++i) {
+                if (!isFirst(i)) continue;
+                ++chunkEdges[c + 1];
+                vtkIdType last = i + 1;
+                while (last < nbHalfEdges && keys[last].key == keys[i].key) ++last;
+                // an edge shared by more than two faces is non-manifold and left unpaired
+                for (auto k = i; k < last; ++k) {
+                    m_heOpposite[keys[k].h] = -1;
+                }
+                if (last - i == 2) {
+                    m_heOpposite[keys[i].h] = keys[i + 1].h;
+                    m_heOpposite[keys[i + 1].h] = keys[i].h;
+                }
+            }
+        }
+    });
+    for (vtkIdType c = 0; c < nbChunks; ++c) {
+        chunkEdges[c + 1] += chunkEdges[c];
+    }
+    m_edges.resize(chunkEdges[nbChunks]);
+    vtkSMPTools::For(0, nbChunks, 1, [&](vtkIdType begin, vtkIdType end) {
+        for (auto c = begin; c < end; ++c) {
+            auto e = chunkEdges[c];
+            for (auto i = c * chunkSize; i < std::min(nbHalfEdges, (c + 1) * chunkSize); ++i) {
+                if (isFirst(i)) {
+                    m_edges[e++] = {static_cast<vtkIdType>(keys[i].key >> vertexBits),
+                                    static_cast<vtkIdType>(keys[i].key & vertexMask)};
+                }
+            }
+        }
+    });
+    keys = {};
+
+    // neighbor ranges, both directions of every edge sorted by their source
+    const vtkIdType nbEdges = m_edges.size();
+    std::vector<std::uint64_t> directed(2 * nbEdges);
+    vtkSMPTools::For(0, nbEdges, [&](vtkIdType begin, vtkIdType end) {
+        for (auto e = begin; e < end; ++e) {
+            std::uint64_t a = m_edges[e].a;
+            std::uint64_t b = m_edges[e].b;
+            directed[2 * e] = (a << vertexBits) | b;
+            directed[2 * e + 1] = (b << vertexBits) | a;
+        }
+    });
+    parallelRadixSort(directed, [](std::uint64_t k) { return k; }, 2 * vertexBits);
+    m_neighborOffsets = parallelRangeOffsets(nbVertices, 2 * nbEdges, [&](vtkIdType i) {
+        return static_cast<vtkIdType>(directed[i] >> vertexBits);
+    });
+    m_neighbors.resize(2 * nbEdges);
+    vtkSMPTools::For(0, 2 * nbEdges, [&](vtkIdType begin, vtkIdType end) {
+        for (auto i = begin; i < end; ++i) m_neighbors[i] = directed[i] & vertexMask;
+    });
+}
+
+bool HalfEdgeMesh::isBoundaryVertex(vtkIdType v) const {
+    for (auto h : outgoing(v)) {
+        if (isBoundary(h) || isBoundary(prev(h))) return true;
+    }
+    return false;
+}
+
+std::size_t HalfEdgeMesh::memoryBytes() const {
+    return (m_faceOffsets.capacity() + m_heVertex.capacity() + m_heFace.capacity() + m_heOpposite.capacity() +
+            m_starOffsets.capacity() + m_star.capacity() + m_neighborOffsets.capacity() + m_neighbors.capacity()) *
+               sizeof(vtkIdType) +
+           m_edges.capacity() * sizeof(Edge);
+}
+
+std::size_t HalfEdgeMesh::predictBytes(vtkPolyData* mesh) {
+    std::size_t nbVertices = mesh->GetNumberOfPoints();
+    std::size_t nbFaces = mesh->GetPolys()->GetNumberOfCells();
+    std::size_t nbHalfEdges = mesh->GetPolys()->GetNumberOfConnectivityIds();
+    std::size_t nbEdges = nbHalfEdges / 2 + 1;
+    std::size_t ids = nbFaces + 1 + 4 * nbHalfEdges + 2 * (nbVertices + 1) + 2 * nbEdges;
+    std::size_t result = ids * sizeof(vtkIdType) + nbEdges * sizeof(Edge);
+    // the edge keys and the radix sort buffer are the largest temporaries
+    std::size_t temporaries = 2 * nbHalfEdges * (sizeof(std::uint64_t) + sizeof(vtkIdType));
+    return result + temporaries;
+}
+
+namespace {
+struct CacheEntry {
+    vtkWeakPointer<vtkCellArray> polys;
+    vtkMTimeType mtime;
+    vtkIdType nbPoints;
+    std::shared_ptr<const HalfEdgeMesh> topology;
+};
+std::mutex cacheMutex;
+std::unordered_map<vtkCellArray*, CacheEntry> cache;
+
+std::shared_ptr<const HalfEdgeMesh> findLocked(vtkPolyData* mesh) {
+    std::erase_if(cache, [](const auto& entry) { return entry.second.polys == nullptr; });
+    vtkCellArray* polys = mesh->GetPolys();
+    if (auto search = cache.find(polys); search != cache.end()) {
+        const auto& entry = search->second;
+        if (entry.mtime == polys->GetMTime() && entry.nbPoints == mesh->GetNumberOfPoints()) {
+            return entry.topology;
+        }
+    }
+    return nullptr;
+}
+}  // namespace
+
+std::shared_ptr<const HalfEdgeMesh> HalfEdgeMesh::find(vtkPolyData* mesh) {
+    std::lock_guard lock(cacheMutex);
+    return findLocked(mesh);
+}
+
+std::shared_ptr<const HalfEdgeMesh> HalfEdgeMesh::get(vtkPolyData* mesh) {
+    {
+        std::lock_guard lock(cacheMutex);
+        if (auto topology = findLocked(mesh)) return topology;
+    }
+    // built outside of the lock so that several meshes can be prepared at the same time
+    auto topology = std::make_shared<const HalfEdgeMesh>(mesh);
+    vtkCellArray* polys = mesh->GetPolys();
+    std::lock_guard lock(cacheMutex);
+    cache[polys] = {polys, polys->GetMTime(), mesh->GetNumberOfPoints(), topology};
+    return topology;
+}
@@ -0,0 +1,75 @@
+#include "MappedFile.hpp"
+
+#include <format>
+#include <fstream>
+#include <stdexcept>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif  // _WIN32
+
+#ifdef _WIN32
+MappedFile::MappedFile(const std::filesystem::path& path, Mode mode) {
+    const bool writable = mode == Mode::ReadWrite;
+    m_size = std::filesystem::file_size(path);
+    m_file = CreateFileW(path.c_str(), writable ? GENERIC_READ | GENERIC_WRITE : GENERIC_READ, FILE_SHARE_READ,
+                         nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (m_file == INVALID_HANDLE_VALUE) throw std::runtime_error(std::format("cannot open {}", path.string()));
+    if (m_size > 0) {
+        m_mapping = CreateFileMappingW(m_file, nullptr, writable ? PAGE_READWRITE : PAGE_READONLY, 0, 0, nullptr);
+        if (m_mapping != nullptr) {
+            m_data = MapViewOfFile(m_mapping, writable ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, 0);
+        }
+        if (m_data == nullptr) {
+            if (m_mapping != nullptr) CloseHandle(m_mapping);
+            CloseHandle(m_file);
+            throw std::runtime_error(std::format("cannot map {}", path.string()));
+        }
+    }
+}
+
+MappedFile::~MappedFile() {
+    if (m_data != nullptr) UnmapViewOfFile(m_data);
+    if (m_mapping != nullptr) CloseHandle(m_mapping);
+    CloseHandle(m_file);
+}
+
+void MappedFile::flush() {
+    if (m_data != nullptr) FlushViewOfFile(m_data, 0);
+}
+#else
+MappedFile::MappedFile(const std::filesystem::path& path, Mode mode) {
+    const bool writable = mode == Mode::ReadWrite;
+    m_size = std::filesystem::file_size(path);
+    m_file = ::open(path.c_str(), writable ? O_RDWR : O_RDONLY);
+    if (m_file < 0) throw std::runtime_error(std::format("cannot open {}", path.string()));
+    if (m_size > 0) {
+        m_data = mmap(nullptr, m_size, writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, m_file, 0);
+        if (m_data == MAP_FAILED) {
+            m_data = nullptr;
+            ::close(m_file);
+            throw std::runtime_error(std::format("cannot map {}", path.string()));
+        }
+    }
+}
+
+MappedFile::~MappedFile() {
+    if (m_data != nullptr) munmap(m_data, m_size);
+    ::close(m_file);
+}
+
+void MappedFile::flush() {
+    if (m_data != nullptr) msync(m_data, m_size, MS_SYNC);
+}
+#endif  // _WIN32
+
+void MappedFile::create(const std::filesystem::path& path, std::size_t size) {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file) throw std::runtime_error(std::format("cannot create {}", path.string()));
+    file.close();
+    std::filesystem::resize_file(path, size);
+}
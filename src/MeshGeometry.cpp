@@ -0,0 +1,206 @@
+#include "MeshGeometry.hpp"
+
+#include <vtkSMPTools.h>
+#include <vtkWeakPointer.h>
+
+#include <Eigen/Geometry>
+#include <algorithm>
+#include <mutex>
+#include <unordered_map>
+
+MeshGeometry::MeshGeometry(vtkPolyData* mesh, std::shared_ptr<const HalfEdgeMesh> topology)
+    : m_topology(std::move(topology)) {
+    const vtkIdType nbFaces = m_topology->numberOfFaces();
+    const vtkIdType nbVertices = m_topology->numberOfVertices();
+    const vtkIdType nbTriangles = m_topology->numberOfHalfEdges() - 2 * nbFaces;
+    m_faceNormals.resize(3 * nbFaces);
+    m_faceAreas.resize(nbFaces);
+    m_vertexNormals.resize(3 * nbVertices);
+    m_vertexAreas.resize(nbVertices);
+    m_cotangents.resize(3 * nbTriangles);
+
+    vtkPoints* points = mesh->GetPoints();
+    vtkSMPTools::For(0, nbFaces, [&](vtkIdType begin, vtkIdType end) {
+        for (vtkIdType f = begin; f < end; ++f) computeFace(points, f);
+    });
+    vtkSMPTools::For(0, nbVertices, [&](vtkIdType begin, vtkIdType end) {
+        for (vtkIdType v = begin; v < end; ++v) computeVertex(v);
+    });
+}
+
+void MeshGeometry::computeFace(vtkPoints* points, vtkIdType f) {
+    using namespace Eigen;
+    Vector3d normal = Vector3d::Zero();
+    double area = 0.0;
+    vtkIdType t = firstTriangle(f);
+    m_topology->forEachTriangle(f, [&](vtkIdType a, vtkIdType b, vtkIdType c) {
+        Vector3d p[3];
+        points->GetPoint(a, p[0].data());
+        points->GetPoint(b, p[1].data());
+        points->GetPoint(c, p[2].data());
+        Vector3d cross = (p[1] - p[0]).cross(p[2] - p[0]);
+        // twice the area of the triangle, the norm of the cross product of any two of its sides
+        double doubleArea = cross.norm();
+        for (int k = 0; k < 3; ++k) {
+            m_cotangents[3 * t + k] = (p[(k + 1) % 3] - p[k]).dot(p[(k + 2) % 3] - p[k]) / doubleArea;
+        }
+        normal += cross;
+        area += 0.5 * doubleArea;
+        ++t;
+    });
+    normal.normalize();
+    Map<Vector3d>(m_faceNormals.data() + 3 * f) = normal;
+    m_faceAreas[f] = area;
+}
+
+void MeshGeometry::computeVertex(vtkIdType v) {
+    using namespace Eigen;
+    Vector3d normal = Vector3d::Zero();
+    double area = 0.0;
+    for (auto h : m_topology->outgoing(v)) {
+        auto f = m_topology->face(h);
+        normal += m_faceAreas[f] * faceNormal(f);
+        area += m_faceAreas[f] / m_topology->faceSize(f);
+    }
+    normal.normalize();
+    Map<Vector3d>(m_vertexNormals.data() + 3 * v) = normal;
+    m_vertexAreas[v] = area;
+}
+
+void MeshGeometry::patch(vtkPoints* points, std::span<const vtkIdType> movedVertices) {
+    // the faces around the moved vertices, then every vertex of these faces
+    std::vector<vtkIdType> faces;
+    for (auto v : movedVertices) {
+        for (auto h : m_topology->outgoing(v)) faces.push_back(m_topology->face(h));
+    }
+    std::ranges::sort(faces);
+    faces.erase(std::unique(faces.begin(), faces.end()), faces.end());
+    std::vector<vtkIdType> vertices;
+    for (auto f : faces) {
+        auto corners = m_topology->faceVertices(f);
+        vertices.insert(vertices.end(), corners.begin(), corners.end());
+    }
+    std::ranges::sort(vertices);
+    vertices.erase(std::unique(vertices.begin(), vertices.end()), vertices.end());
+
+    vtkSMPTools::For(0, static_cast<vtkIdType>(faces.size()), [&](vtkIdType begin, vtkIdType end) {
+        for (vtkIdType i = begin; i < end; ++i) computeFace(points, faces[i]);
+    });
+    vtkSMPTools::For(0, static_cast<vtkIdType>(vertices.size()), [&](vtkIdType begin, vtkIdType end) {
+        for (vtkIdType i = begin; i < end; ++i) computeVertex(vertices[i]);
+    });
+}
+
+void MeshGeometry::cotangentStiffness(std::pmr::vector<Eigen::Triplet<double>>& triplets) const {
+    auto addEdge = [&](vtkIdType i, vtkIdType j, double cotan) {
+        double halfCotan = 0.5 * cotan;
+        triplets.emplace_back(i, j, -halfCotan);
+        triplets.emplace_back(j, i, -halfCotan);
+        triplets.emplace_back(i, i, halfCotan);
+        triplets.emplace_back(j, j, halfCotan);
+    };
+    triplets.reserve(triplets.size() + 4 * m_cotangents.size());
+    for (vtkIdType f = 0; f < m_topology->numberOfFaces(); ++f) {
+        auto t = firstTriangle(f);
+        m_topology->forEachTriangle(f, [&](vtkIdType a, vtkIdType b, vtkIdType c) {
+            // the edge opposite to each corner
+            addEdge(b, c, cotangent(t, 0));
+            addEdge(c, a, cotangent(t, 1));
+            addEdge(a, b, cotangent(t, 2));
+            ++t;
+        });
+    }
+}
+
+double MeshGeometry::meanEdgeLength(vtkPoints* points) const {
+    auto edges = m_topology->edges();
+    if (edges.empty()) return 0.0;
+    double edgeLengths = 0.0;
+    for (auto [a, b] : edges) {
+        Eigen::Vector3d p, q;
+        points->GetPoint(a, p.data());
+        points->GetPoint(b, q.data());
+        edgeLengths += (p - q).norm();
+    }
+    return edgeLengths / static_cast<double>(edges.size());
+}
+
+std::size_t MeshGeometry::memoryBytes() const {
+    return (m_faceNormals.capacity() + m_faceAreas.capacity() + m_vertexNormals.capacity() +
+            m_vertexAreas.capacity() + m_cotangents.capacity()) *
+           sizeof(double);
+}
+
+std::size_t MeshGeometry::predictBytes(vtkPolyData* mesh) {
+    std::size_t nbVertices = mesh->GetNumberOfPoints();
+    std::size_t nbFaces = mesh->GetPolys()->GetNumberOfCells();
+    std::size_t nbTriangles = mesh->GetPolys()->GetNumberOfConnectivityIds() - 2 * nbFaces;
+    return (4 * nbFaces + 4 * nbVertices + 3 * nbTriangles) * sizeof(double);
+}
+
+std::size_t MeshGeometry::predictStiffnessNonZeros(vtkPolyData* mesh) {
+    std::size_t nbPoints = mesh->GetNumberOfPoints();
+    std::size_t nbTriangles = mesh->GetPolys()->GetNumberOfConnectivityIds() - 2 * mesh->GetPolys()->GetNumberOfCells();
+    // every interior edge is shared by two triangles, and appears twice in the matrix
+    return nbPoints + 3 * nbTriangles;
+}
+
+namespace {
+struct CacheEntry {
+    vtkWeakPointer<vtkPolyData> mesh;
+    vtkPoints* points;
+    vtkMTimeType mtime;
+    std::shared_ptr<MeshGeometry> geometry;
+};
+std::mutex cacheMutex;
+std::unordered_map<vtkPolyData*, CacheEntry> cache;
+
+// the entry of the mesh if it was built on the current topology and points, whatever their positions
+CacheEntry* findEntryLocked(vtkPolyData* mesh) {
+    std::erase_if(cache, [](const auto& entry) { return entry.second.mesh == nullptr; });
+    if (auto search = cache.find(mesh); search != cache.end()) {
+        auto& entry = search->second;
+        if (entry.points == mesh->GetPoints() && HalfEdgeMesh::find(mesh).get() == &entry.geometry->topology()) {
+            return &entry;
+        }
+    }
+    return nullptr;
+}
+
+std::shared_ptr<const MeshGeometry> findLocked(vtkPolyData* mesh) {
+    auto entry = findEntryLocked(mesh);
+    if (entry != nullptr && entry->mtime == mesh->GetPoints()->GetMTime()) return entry->geometry;
+    return nullptr;
+}
+}  // namespace
+
+std::shared_ptr<const MeshGeometry> MeshGeometry::find(vtkPolyData* mesh) {
+    std::lock_guard lock(cacheMutex);
+    return findLocked(mesh);
+}
+
+std::shared_ptr<const MeshGeometry> MeshGeometry::get(vtkPolyData* mesh) {
+    {
+        std::lock_guard lock(cacheMutex);
+        if (auto geometry = findLocked(mesh)) return geometry;
+    }
+    auto geometry = std::make_shared<MeshGeometry>(mesh, HalfEdgeMesh::get(mesh));
+    std::lock_guard lock(cacheMutex);
+    cache[mesh] = {mesh, mesh->GetPoints(), mesh->GetPoints()->GetMTime(), geometry};
+    return geometry;
+}
+
+void MeshGeometry::update(vtkPolyData* mesh, std::span<const vtkIdType> movedVertices) {
+    std::shared_ptr<MeshGeometry> geometry;
+    {
+        std::lock_guard lock(cacheMutex);
+        if (auto entry = findEntryLocked(mesh)) geometry = entry->geometry;
+    }
+    // never built, or built on other points or faces, the next get() rebuilds it
+    if (geometry == nullptr) return;
+    geometry->patch(mesh->GetPoints(), movedVertices);
+    std::lock_guard lock(cacheMutex);
+    if (auto entry = findEntryLocked(mesh); entry != nullptr && entry->geometry == geometry) {
+        entry->mtime = mesh->GetPoints()->GetMTime();
+    }
+}
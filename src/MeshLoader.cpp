@@ -0,0 +1,110 @@
+#include "MeshLoader.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <exception>
+#include <system_error>
+
+#include "fileIO.hpp"
+
+MeshLoader::MeshLoader(unsigned nbThreads) : m_pool(nbThreads) {}
+
+MeshLoader::~MeshLoader() {
+    for (auto& load : m_loads) {
+        load->stop.request_stop();
+    }
+    // the pool is destroyed first, it waits for the running loads
+}
+
+namespace {
+/**
+ * Runs a step of a load on a worker, a failure ends the load.
+ *
+ * @return false when the step failed.
+ */
+template <typename Step>
+bool runStep(MeshLoader::Load* load, Step&& step) {
+    auto start = std::chrono::steady_clock::now();
+    bool succeeded = true;
+    try {
+        step();
+    } catch (const std::exception& e) {
+        load->error = e.what();
+        succeeded = false;
+    }
+    load->seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return succeeded;
+}
+}  // namespace
+
+void MeshLoader::load(const std::filesystem::path& path, bool reorder) {
+    auto load = std::make_unique<Load>();
+    load->path = path;
+    load->reorder = reorder;
+    std::error_code error;
+    load->bytes = std::max<std::uintmax_t>(std::filesystem::file_size(path, error), 1);
+    if (path.extension() != ".obj" && path.extension() != ".ply") {
+        load->progress = 1.0;
+        load->done = true;
+    } else {
+        m_pool.submit([load = load.get()] {
+            if (runStep(load, [load] { load->key = meshKey(load->path, load->reorder); })) {
+                load->keyed = true;
+            } else {
+                load->progress = 1.0;
+                load->done = true;
+            }
+        });
+    }
+    m_loads.push_back(std::move(load));
+}
+
+void MeshLoader::startReading(Load& load) {
+    if (load.stop.stop_requested()) {
+        load.progress = 1.0;
+        load.done = true;
+        return;
+    }
+    // a file already opened shares the arrays of its first mesh instead of being read again
+    if (auto shared = findSharedMesh(load.key)) {
+        load.mesh = shared;
+        load.progress = 1.0;
+        load.done = true;
+        return;
+    }
+    load.reading = true;
+    m_pool.submit([load = &load] {
+        runStep(load, [load] {
+            auto mesh = readMesh(
+                load->path, load->reorder, [load](double progress) { load->progress = readFraction * progress; },
+                load->stop.get_token());
+            if (mesh) load->hashes = hashMesh(mesh);
+            load->mesh = mesh;
+        });
+        load->progress = 1.0;
+        load->done = true;
+    });
+}
+
+std::vector<std::unique_ptr<MeshLoader::Load>> MeshLoader::takeFinished() {
+    std::vector<std::unique_ptr<Load>> finished;
+    for (auto& load : m_loads) {
+        if (load->keyed && !load->reading && !load->done) startReading(*load);
+        if (!load->done) continue;
+        // the arrays of a mesh read are shared here, between two frames, while no deformation modifies them
+        if (load->reading && load->mesh) load->mesh = shareMesh(load->key, load->mesh, load->hashes);
+        finished.push_back(std::move(load));
+    }
+    std::erase(m_loads, nullptr);
+    return finished;
+}
+
+double MeshLoader::progress() const {
+    double read = 0.0;
+    double total = 0.0;
+    for (const auto& load : m_loads) {
+        read += load->progress * static_cast<double>(load->bytes);
+        total += static_cast<double>(load->bytes);
+    }
+    return total > 0.0 ? read / total : 1.0;
+}
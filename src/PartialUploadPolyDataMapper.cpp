@@ -0,0 +1,118 @@
+#include "PartialUploadPolyDataMapper.hpp"
+
+#include <vtkCellArray.h>
+#include <vtkCellData.h>
+#include <vtkDataArray.h>
+#include <vtkObjectFactory.h>
+#include <vtkOpenGLVertexBufferObject.h>
+#include <vtkOpenGLVertexBufferObjectGroup.h>
+#include <vtkPointData.h>
+#include <vtkPolyData.h>
+#include <vtkProperty.h>
+#include <vtkScalarsToColors.h>
+#include <vtk_glew.h>
+
+#include <algorithm>
+#include <vector>
+
+vtkStandardNewMacro(PartialUploadPolyDataMapper);
+
+void PartialUploadPolyDataMapper::addModifiedPoints(vtkIdType begin, vtkIdType end) {
+    if (begin < end) m_modified.emplace_back(begin, end);
+}
+
+void PartialUploadPolyDataMapper::UpdateBufferObjects(vtkRenderer* ren, vtkActor* act) {
+    if (onlyPointsModified(act)) {
+        if (m_modified.empty()) m_modified.emplace_back(0, this->CurrentInput->GetNumberOfPoints());
+        if (uploadPoints(m_modified)) {
+            m_modified.clear();
+            // the build state of the superclass takes the new modification time of the input, otherwise the next
+            // render would find it stale and upload every buffer again
+            this->GetNeedToRebuildBufferObjects(ren, act);
+            this->VBOBuildTime.Modified();
+            ++m_partialUploads;
+            return;
+        }
+    }
+    Superclass::UpdateBufferObjects(ren, act);
+    m_uploadedPoints = this->CurrentInput->GetPoints();
+    m_modified.clear();
+}
+
+void PartialUploadPolyDataMapper::BuildBufferObjects(vtkRenderer* ren, vtkActor* act) {
+    Superclass::BuildBufferObjects(ren, act);
+    ++m_fullUploads;
+}
+
+bool PartialUploadPolyDataMapper::onlyPointsModified(vtkActor* act) const {
+    vtkPolyData* input = this->CurrentInput;
+    const vtkMTimeType built = this->VBOBuildTime.GetMTime();
+    if (built == 0 || input == nullptr || input->GetPoints() == nullptr || input->GetPoints() != m_uploadedPoints) {
+        return false;
+    }
+    if (input->GetPoints()->GetMTime() <= built) return false;
+    // the normals would be stale, and the uploaded cell attributes are laid out with the cells
+    if (input->GetPointData()->GetNormals() != nullptr || uploadsCellAttributes(input)) return false;
+    for (vtkMTimeType mtime : {input->GetVerts()->GetMTime(), input->GetLines()->GetMTime(),
+                               input->GetPolys()->GetMTime(), input->GetStrips()->GetMTime(),
+                               input->GetPointData()->GetMTime(), this->GetMTime(), act->GetProperty()->GetMTime()}) {
+        if (mtime > built) return false;
+    }
+    return this->LookupTable == nullptr || this->LookupTable->GetMTime() <= built;
+}
+
+bool PartialUploadPolyDataMapper::uploadsCellAttributes(vtkPolyData* input) const {
+    if (input->GetCellData()->GetNormals() != nullptr) return true;
+    if (!this->ScalarVisibility) return false;
+    int cellFlag = 0;
+    vtkDataArray* scalars = vtkAbstractMapper::GetScalars(input, this->ScalarMode, this->ArrayAccessMode,
+                                                          this->ArrayId, this->ArrayName, cellFlag);
+    return scalars != nullptr && cellFlag == 1;
+}
+
+bool PartialUploadPolyDataMapper::uploadPoints(std::vector<std::pair<vtkIdType, vtkIdType>>& ranges) {
+    vtkOpenGLVertexBufferObject* vbo = this->VBOs->GetVBO("vertexMC");
+    vtkPoints* points = this->CurrentInput->GetPoints();
+    const vtkIdType nbPoints = points->GetNumberOfPoints();
+    if (vbo == nullptr || vbo->GetDataType() != VTK_FLOAT ||
+        static_cast<vtkIdType>(vbo->GetNumberOfTuples()) != nbPoints) {
+        return false;
+    }
+
+    // the ranges are sorted and merged in place, the close ones are sent as one update
+    std::sort(ranges.begin(), ranges.end());
+    std::size_t merged = 0;
+    for (const auto& [begin, end] : ranges) {
+        if (merged > 0 && begin <= ranges[merged - 1].second + mergeGap) {
+            ranges[merged - 1].second = std::max(ranges[merged - 1].second, end);
+        } else {
+            ranges[merged++] = {begin, end};
+        }
+    }
+    ranges.resize(merged);
+
+    // same conversion as the full upload, shifted and scaled floats at the stride of the buffer
+    const bool shiftScale = vbo->GetCoordShiftAndScaleEnabled();
+    const auto& shift = vbo->GetShift();
+    const auto& scale = vbo->GetScale();
+    const std::size_t stride = vbo->GetStride() / sizeof(float);
+    std::vector<float> values;
+    double p[3];
+    vbo->Bind();
+    for (auto [begin, end] : ranges) {
+        end = std::min(end, nbPoints);
+        if (begin >= end) continue;
+        values.assign((end - begin) * stride, 0.0f);
+        for (vtkIdType i = begin; i < end; ++i) {
+            points->GetPoint(i, p);
+            float* value = values.data() + (i - begin) * stride;
+            for (int k = 0; k < 3; ++k) {
+                value[k] = static_cast<float>(shiftScale ? (p[k] - shift[k]) * scale[k] : p[k]);
+            }
+        }
+        glBufferSubData(GL_ARRAY_BUFFER, static_cast<GLintptr>(begin * vbo->GetStride()),
+                        static_cast<GLsizeiptr>(values.size() * sizeof(float)), values.data());
+    }
+    vbo->Release();
+    return true;
+}
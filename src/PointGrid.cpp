@@ -0,0 +1,127 @@
+#include "PointGrid.hpp"
+
+#include <vtkSMPTools.h>
+#include <vtkWeakPointer.h>
+
+#include <bit>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+
+#include "parallelSort.hpp"
+
+namespace {
+struct SortKey {
+    std::uint64_t cell;
+    vtkIdType id;
+};
+
+constexpr std::size_t maxCellsPerPoint = 4;
+
+std::array<int, 3> gridDimensions(const double bounds[6], std::size_t nbPoints, double& cellSize) {
+    std::array<double, 3> extent = {bounds[1] - bounds[0], bounds[3] - bounds[2], bounds[5] - bounds[4]};
+    const double largest = std::max({extent[0], extent[1], extent[2], 1e-300});
+    // one cell per point in the bounding box, the flat axes counted as a thousandth of the largest one
+    double volume = 1.0;
+    for (double e : extent) volume *= std::max(e, 1e-3 * largest);
+    // at most a million cells along the largest axis, and never 0 when all the points coincide
+    cellSize = std::max(std::cbrt(volume / static_cast<double>(std::max<std::size_t>(nbPoints, 1))), 1e-6 * largest);
+    std::array<int, 3> dims;
+    for (;;) {
+        std::size_t cells = 1;
+        for (int k = 0; k < 3; ++k) {
+            dims[k] = std::max(1, static_cast<int>(std::ceil(extent[k] / cellSize)));
+            cells *= dims[k];
+        }
+        if (cells <= maxCellsPerPoint * std::max<std::size_t>(nbPoints, 1)) return dims;
+        cellSize *= 1.25;
+    }
+}
+}  // namespace
+
+PointGrid::PointGrid(vtkPoints* points) {
+    const vtkIdType nbPoints = points->GetNumberOfPoints();
+    if (nbPoints == 0) {
+        m_cellStart = {0, 0};
+        return;
+    }
+    double bounds[6];
+    points->GetBounds(bounds);
+    m_dims = gridDimensions(bounds, nbPoints, m_cellSize);
+    for (int k = 0; k < 3; ++k) m_origin[k] = bounds[2 * k];
+
+    std::vector<SortKey> keys(nbPoints);
+    vtkSMPTools::For(0, nbPoints, [&](vtkIdType begin, vtkIdType end) {
+        double p[3];
+        for (vtkIdType i = begin; i < end; ++i) {
+            points->GetPoint(i, p);
+            std::uint64_t cell = (static_cast<std::uint64_t>(cellCoordinate(p[2], 2)) * m_dims[1] +
+                                  static_cast<std::uint64_t>(cellCoordinate(p[1], 1))) *
+                                     m_dims[0] +
+                                 static_cast<std::uint64_t>(cellCoordinate(p[0], 0));
+            keys[i] = {cell, i};
+        }
+    });
+    const auto nbCells = static_cast<vtkIdType>(m_dims[0]) * m_dims[1] * m_dims[2];
+    const int cellBits = std::bit_width(static_cast<std::uint64_t>(nbCells));
+    parallelRadixSort(keys, [](const SortKey& k) { return k.cell; }, cellBits);
+    m_cellStart =
+        parallelRangeOffsets(nbCells, nbPoints, [&](vtkIdType i) { return static_cast<vtkIdType>(keys[i].cell); });
+
+    m_ids.resize(nbPoints);
+    m_positions.resize(3 * nbPoints);
+    vtkSMPTools::For(0, nbPoints, [&](vtkIdType begin, vtkIdType end) {
+        for (vtkIdType i = begin; i < end; ++i) {
+            m_ids[i] = keys[i].id;
+            points->GetPoint(keys[i].id, m_positions.data() + 3 * i);
+        }
+    });
+}
+
+std::size_t PointGrid::memoryBytes() const {
+    return (m_cellStart.capacity() + m_ids.capacity()) * sizeof(vtkIdType) + m_positions.capacity() * sizeof(double);
+}
+
+std::size_t PointGrid::predictBytes(vtkPolyData* mesh) {
+    std::size_t nbPoints = mesh->GetNumberOfPoints();
+    // the sort keys and the radix sort buffer while building, then the cells, ids and positions
+    return 2 * nbPoints * sizeof(SortKey) + (maxCellsPerPoint + 2) * nbPoints * sizeof(vtkIdType) +
+           3 * nbPoints * sizeof(double);
+}
+
+namespace {
+// keyed by the points, the meshes sharing their points share their grid
+struct CacheEntry {
+    vtkWeakPointer<vtkPoints> points;
+    vtkMTimeType mtime;
+    std::shared_ptr<const PointGrid> grid;
+};
+std::mutex cacheMutex;
+std::unordered_map<vtkPoints*, CacheEntry> cache;
+
+std::shared_ptr<const PointGrid> findLocked(vtkPolyData* mesh) {
+    std::erase_if(cache, [](const auto& entry) { return entry.second.points == nullptr; });
+    if (auto search = cache.find(mesh->GetPoints()); search != cache.end()) {
+        auto& entry = search->second;
+        if (entry.mtime == mesh->GetPoints()->GetMTime()) return entry.grid;
+    }
+    return nullptr;
+}
+}  // namespace
+
+std::shared_ptr<const PointGrid> PointGrid::find(vtkPolyData* mesh) {
+    std::lock_guard lock(cacheMutex);
+    return findLocked(mesh);
+}
+
+std::shared_ptr<const PointGrid> PointGrid::get(vtkPolyData* mesh) {
+    {
+        std::lock_guard lock(cacheMutex);
+        if (auto grid = findLocked(mesh)) return grid;
+    }
+    auto grid = std::make_shared<const PointGrid>(mesh->GetPoints());
+    std::lock_guard lock(cacheMutex);
+    cache[mesh->GetPoints()] = {mesh->GetPoints(), mesh->GetPoints()->GetMTime(), grid};
+    return grid;
+}
@@ -0,0 +1,333 @@
+#include "ProgressiveWeights.hpp"
+
+#include <vtkPolyData.h>
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+#include "HalfEdgeMesh.hpp"
+#include "ScratchArena.hpp"
+#include "harmonicFn.hpp"
+#include "memoryUsage.hpp"
+
+namespace {
+using Clock = std::chrono::steady_clock;
+
+// the clock is read once per block of points of a diffusion iteration or of the assembly of the laplace equations
+constexpr vtkIdType pointsPerClockRead = 4096;
+}  // namespace
+
+bool ProgressiveWeights::computes(const WeightParameters& parameters) const {
+    return m_stage != Stage::Idle && m_mesh != nullptr && m_parameters == parameters;
+}
+
+void ProgressiveWeights::start(const WeightParameters& parameters) {
+    stop();
+    m_parameters = parameters;
+    m_mesh = parameters.mesh;
+    m_stage = Stage::Coarse;
+}
+
+void ProgressiveWeights::stop() {
+    m_stage = Stage::Idle;
+    m_mesh = nullptr;
+    m_weights = nullptr;
+    m_topology.reset();
+    m_current.reset();
+    m_next.reset();
+    m_ringMap = {};
+    m_ringPoints = {};
+    m_rows.reset();
+    m_ringFaces = {};
+    m_triplets = {};
+    m_matrix.resize(0, 0);
+    m_rhs.resize(0);
+    m_solution.resize(0);
+}
+
+bool ProgressiveWeights::refine(std::chrono::duration<double> budget) {
+    if (!running()) return false;
+    if (m_mesh == nullptr) {
+        // the mesh was removed while its field was computed
+        stop();
+        return false;
+    }
+    auto deadline = Clock::now() + std::chrono::duration_cast<Clock::duration>(budget);
+    bool changed = false;
+    bool first = true;
+    do {
+        switch (m_stage) {
+            case Stage::Coarse:
+                coarseStep();
+                changed = true;
+                break;
+            case Stage::Diffusion:
+                changed = diffusionStep(deadline) || changed;
+                break;
+            case Stage::Rings:
+                ringsStep(deadline);
+                break;
+            case Stage::Faces:
+                facesStep(deadline);
+                break;
+            case Stage::Triplets:
+                tripletsStep(deadline);
+                break;
+            case Stage::Matrix:
+                // the matrix is built at once, it starts a frame instead of overrunning the one of the last triplets
+                if (!first) return changed;
+                matrixStep();
+                break;
+            case Stage::Solve:
+                solveStep(deadline);
+                changed = true;
+                break;
+            default:
+                break;
+        }
+        first = false;
+    } while (running() && Clock::now() < deadline);
+    return changed;
+}
+
+double ProgressiveWeights::progress() const {
+    if (!running() && !finished()) return 0.0;
+    switch (m_stage) {
+        case Stage::Done:
+            return 1.0;
+        case Stage::Diffusion: {
+            // the mesh may have been removed since the last refine
+            if (m_mesh == nullptr) return 0.0;
+            double iteration = static_cast<double>(m_nextPoint) / std::max<vtkIdType>(1, m_mesh->GetNumberOfPoints());
+            return (m_iteration + iteration) / m_parameters.ringCount;
+        }
+        case Stage::Solve: {
+            // the residual decreases about geometrically, the progress is the fraction of its digits already gained
+            if (m_error >= m_initialError) return 0.0;
+            return std::clamp(std::log(m_error / m_initialError) / std::log(tolerance / m_initialError), 0.0, 1.0);
+        }
+        default:
+            return 0.0;
+    }
+}
+
+void ProgressiveWeights::coarseStep() {
+    const auto& p = m_parameters;
+    if (p.method == 1 && p.ringCount > 0) {
+        // the diffusion spreads by one ring per iteration, its support is covered by iterations + 1 rings
+        m_weights = simpleHarmonic(m_mesh, p.pointId, p.ringCount + 1);
+        m_topology = HalfEdgeMesh::get(m_mesh);
+        m_current = std::make_shared<ValueMap>();
+        m_next = std::make_shared<ValueMap>();
+        (*m_current)[p.pointId] = 1.0;
+        m_iteration = 0;
+        m_nextPoint = 0;
+        m_stage = Stage::Diffusion;
+    } else if (p.method == 2 && p.ringCount > 1) {
+        m_weights = simpleHarmonic(m_mesh, p.pointId, p.ringCount);
+        m_topology = HalfEdgeMesh::get(m_mesh);
+        m_ringMap[p.pointId] = 0;
+        m_ringPoints.assign({p.pointId});
+        m_nextRingPoint = 0;
+        m_stage = Stage::Rings;
+    } else {
+        // simple harmonic, spectral and radius weights, and the diffusion and laplace weights of a single point
+        m_weights = weightingFunction(p.method, m_mesh, p.pointId, p.ringCount, p.alpha, p.nbModes, p.radius);
+        m_stage = Stage::Done;
+    }
+}
+
+bool ProgressiveWeights::diffusionStep(Clock::time_point deadline) {
+    // the iterations of laplacianDiffusion, resumed at m_nextPoint of iteration m_iteration
+    const double alpha = m_parameters.alpha;
+    const vtkIdType nbPoints = m_mesh->GetNumberOfPoints();
+    if (m_nextPoint == 0 && m_next.use_count() > 1) {
+        // the values of an earlier iteration are still used by published weights
+        m_next = std::make_shared<ValueMap>(*m_next);
+    }
+    auto& f = *m_current;
+    auto& g = *m_next;
+    for (vtkIdType done = 1; m_nextPoint < nbPoints; ++m_nextPoint, ++done) {
+        if (done % pointsPerClockRead == 0 && Clock::now() >= deadline) return false;
+        auto neighbors = m_topology->neighbors(m_nextPoint);
+        if (neighbors.empty()) continue;
+        double weight = 0.0;
+        double weightOfNeighbors = 0.0;
+        if (auto search = f.find(m_nextPoint); search != f.end()) {
+            weight = search->second;
+        }
+        for (auto neighbor : neighbors) {
+            if (auto search = f.find(neighbor); search != f.end()) {
+                weightOfNeighbors += search->second;
+            }
+        }
+        if (weight > 0.0 || weightOfNeighbors > 0.0) {
+            g[m_nextPoint] = (1.0 - alpha) * weight + alpha * (1.0 / neighbors.size()) * weightOfNeighbors;
+        }
+    }
+    std::swap(m_current, m_next);
+    m_nextPoint = 0;
+    ++m_iteration;
+    publishDiffusion();
+    if (m_iteration == m_parameters.ringCount) {
+        m_topology.reset();
+        m_next.reset();
+        m_stage = Stage::Done;
+    }
+    return true;
+}
+
+void ProgressiveWeights::ringsStep(Clock::time_point deadline) {
+    // the breadth-first search of buildRingMap, resumed at m_nextRingPoint, which visits the points ring by ring
+    const long lastRing = m_parameters.ringCount - 1;
+    bool searched = m_topology->dispatchArity([&](auto arity) {
+        for (vtkIdType done = 1; m_nextRingPoint < m_ringPoints.size(); ++m_nextRingPoint, ++done) {
+            if (done % pointsPerClockRead == 0 && Clock::now() >= deadline) return false;
+            auto ptId = m_ringPoints[m_nextRingPoint];
+            const long ring = m_ringMap.find(ptId)->second;
+            // the points left are all on the last ring
+            if (ring == lastRing) break;
+            m_topology->forEachFaceNeighbor<decltype(arity)::value>(ptId, [&](vtkIdType neighbor) {
+                if (m_ringMap.try_emplace(neighbor, ring + 1).second) m_ringPoints.push_back(neighbor);
+            });
+        }
+        return true;
+    });
+    if (!searched) return;
+    // the points of the last ring are fixed, the rings may also end before it on a small mesh
+    m_lastRingStart = static_cast<long>(m_ringPoints.size());
+    while (m_lastRingStart > 0 && m_ringMap.find(m_ringPoints[m_lastRingStart - 1])->second == lastRing) {
+        --m_lastRingStart;
+    }
+    m_rows = std::make_shared<std::pmr::map<vtkIdType, long>>();
+    m_nextRingPoint = 0;
+    m_stage = Stage::Faces;
+}
+
+void ProgressiveWeights::facesStep(Clock::time_point deadline) {
+    // the rows of ringRows, the points being in ring order, and the faces of the rings, a block of points at a time
+    std::span<const vtkIdType> points(m_ringPoints);
+    while (m_nextRingPoint < points.size()) {
+        if (m_nextRingPoint > 0 && Clock::now() >= deadline) return;
+        auto count = std::min<std::size_t>(pointsPerClockRead, points.size() - m_nextRingPoint);
+        auto block = points.subspan(m_nextRingPoint, count);
+        for (auto ptId : block) {
+            m_rows->emplace(ptId, static_cast<long>(m_nextRingPoint++));
+        }
+        appendRingFaces(*m_topology, block, m_ringMap, m_ringFaces);
+    }
+    m_triplets.reserve(12 * m_ringFaces.size() + m_ringPoints.size());
+    m_nextFace = 0;
+    m_stage = Stage::Triplets;
+}
+
+void ProgressiveWeights::tripletsStep(Clock::time_point deadline) {
+    // the entries of laplacianMatrix, a block of faces at a time
+    std::span<const vtkIdType> faces(m_ringFaces);
+    while (m_nextFace < faces.size()) {
+        if (m_nextFace > 0 && Clock::now() >= deadline) return;
+        auto count = std::min<std::size_t>(pointsPerClockRead, faces.size() - m_nextFace);
+        addRingTriplets(m_mesh, faces.subspan(m_nextFace, count), *m_rows, m_lastRingStart, m_triplets);
+        m_nextFace += count;
+    }
+    // the rows of the last ring have no other entries
+    for (long i = m_lastRingStart; i < static_cast<long>(m_ringPoints.size()); ++i) {
+        m_triplets.emplace_back(i, i, 1.0);
+    }
+    m_ringFaces = {};
+    m_stage = Stage::Matrix;
+}
+
+void ProgressiveWeights::matrixStep() {
+    using namespace Eigen;
+    MemoryScope scope("progressiveWeights");
+    const auto& p = m_parameters;
+    const auto nbPoints = static_cast<Index>(m_ringPoints.size());
+    m_matrix.resize(nbPoints, nbPoints);
+    m_matrix.setFromTriplets(m_triplets.begin(), m_triplets.end());
+    MemoryScope::observe(containerBytes(m_ringMap) + containerBytes(m_ringPoints) + containerBytes(*m_rows) +
+                         containerBytes(m_triplets) + m_matrix.nonZeros() * (sizeof(double) + sizeof(int)));
+    m_triplets = {};
+
+    m_rhs = VectorXd::Zero(nbPoints);
+    m_rhs(0) = 1.0;
+    // the guess is the falloff, 1 at the point and 0 on the fixed last ring, scaled to fit the right hand side best
+    VectorXd guess(nbPoints);
+    const double lastRing = p.ringCount - 1;
+    for (Index row = 0; row < nbPoints; ++row) {
+        guess[row] = (lastRing - m_ringMap.find(m_ringPoints[row])->second) / lastRing;
+    }
+    m_ringMap = {};
+    m_ringPoints = {};
+    m_topology.reset();
+    VectorXd applied = m_matrix * guess;
+    double squaredNorm = applied.squaredNorm();
+    m_solution = squaredNorm > 0.0 ? (applied.dot(m_rhs) / squaredNorm) * guess : guess;
+    m_initialError = m_error = (m_rhs - m_matrix * m_solution).norm();
+
+    // the diagonal preconditioner of BiCGSTAB is computed in a single pass over the matrix
+    m_solver.setTolerance(tolerance);
+    m_solver.compute(m_matrix);
+    m_solverIterations = 8;
+    m_totalIterations = 0;
+    m_stage = Stage::Solve;
+}
+
+void ProgressiveWeights::solveStep(Clock::time_point deadline) {
+    using namespace Eigen;
+    // the solver starts again from the current iterate, with as many iterations as the rest of the budget allows
+    auto begin = Clock::now();
+    m_solver.setMaxIterations(m_solverIterations);
+    VectorXd solution = m_solver.solveWithGuess(m_rhs, m_solution);
+    auto info = m_solver.info();
+    if (info == Success || info == NoConvergence) {
+        m_solution = std::move(solution);
+        m_error = m_solver.error();
+        m_totalIterations += m_solver.iterations();
+    }
+    if (info == Success) {
+        m_stage = Stage::Done;
+    } else if (info != NoConvergence || m_totalIterations > std::max<Index>(1000, m_matrix.rows())) {
+        // breakdown or stagnation, the direct solve of solveLaplace ends the computation
+        SparseLU<SparseMatrix<double>> lu;
+        lu.compute(m_matrix);
+        if (lu.info() == Success) m_solution = lu.solve(m_rhs);
+        m_error = tolerance;
+        m_stage = Stage::Done;
+    } else {
+        auto elapsed = Clock::now() - begin;
+        auto remaining = deadline - Clock::now();
+        if (elapsed * 4 < remaining) {
+            m_solverIterations *= 2;
+        } else if (elapsed > remaining && m_solverIterations > 1) {
+            m_solverIterations /= 2;
+        }
+    }
+    publishSolution();
+    if (finished()) {
+        m_matrix.resize(0, 0);
+        m_rhs.resize(0);
+    }
+}
+
+void ProgressiveWeights::publishDiffusion() {
+    m_weights = [values = std::shared_ptr<const ValueMap>(m_current)](vtkIdType ptId) {
+        if (auto search = values->find(ptId); search != values->end()) {
+            return search->second;
+        } else {
+            return 0.0;
+        }
+    };
+}
+
+void ProgressiveWeights::publishSolution() {
+    std::shared_ptr<const std::pmr::map<vtkIdType, long>> rows = m_rows;
+    m_weights = [rows, solution = m_solution](vtkIdType ptId) {
+        if (auto search = rows->find(ptId); search != rows->end()) {
+            return std::abs(solution[search->second]);
+        } else {
+            return 0.0;
+        }
+    };
+}
@@ -0,0 +1,84 @@
+#include "ScratchArena.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <optional>
+
+namespace {
+// forwards to another resource, counting what goes through
+class CountingResource : public std::pmr::memory_resource {
+   public:
+    void reset(std::pmr::memory_resource* upstream) {
+        m_upstream = upstream;
+        m_allocations = 0;
+        m_bytes = 0;
+    }
+    std::size_t allocations() const { return m_allocations; }
+    std::size_t bytes() const { return m_bytes; }
+
+   private:
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override {
+        ++m_allocations;
+        m_bytes += bytes;
+        return m_upstream->allocate(bytes, alignment);
+    }
+    void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override {
+        m_upstream->deallocate(p, bytes, alignment);
+    }
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+    std::pmr::memory_resource* m_upstream = std::pmr::new_delete_resource();
+    std::size_t m_allocations = 0;
+    std::size_t m_bytes = 0;
+};
+
+struct ThreadArena {
+    int depth = 0;
+    std::unique_ptr<std::byte[]> buffer;
+    std::size_t bufferSize = 0;
+    CountingResource heap;
+    std::optional<std::pmr::monotonic_buffer_resource> arena;
+    CountingResource counted;
+};
+thread_local ThreadArena threadArena;
+
+std::atomic<std::size_t> totalAllocations = 0;
+std::atomic<std::size_t> totalBytes = 0;
+std::atomic<std::size_t> totalHeapBlocks = 0;
+}  // namespace
+
+std::pmr::memory_resource* ScratchArena::resource() {
+    if (threadArena.depth == 0) return std::pmr::get_default_resource();
+    return &threadArena.counted;
+}
+
+void ScratchArena::acquire() {
+    auto& thread = threadArena;
+    if (thread.depth++ > 0) return;
+    thread.heap.reset(std::pmr::new_delete_resource());
+    if (thread.buffer != nullptr) {
+        thread.arena.emplace(thread.buffer.get(), thread.bufferSize, &thread.heap);
+    } else {
+        thread.arena.emplace(&thread.heap);
+    }
+    thread.counted.reset(&*thread.arena);
+}
+
+ArenaCounters ScratchArena::release() {
+    auto& thread = threadArena;
+    if (--thread.depth > 0) return {};
+    ArenaCounters counters = {thread.counted.allocations(), thread.counted.bytes(), thread.heap.allocations()};
+    thread.arena.reset();
+    // the next operation of the same size fits in the retained buffer
+    if (counters.heapBlocks > 0 && thread.bufferSize < retainedLimit) {
+        thread.bufferSize = std::min(retainedLimit, std::max(thread.bufferSize + thread.heap.bytes(), counters.bytes));
+        thread.buffer = std::make_unique_for_overwrite<std::byte[]>(thread.bufferSize);
+    }
+    totalAllocations += counters.allocations;
+    totalBytes += counters.bytes;
+    totalHeapBlocks += counters.heapBlocks;
+    return counters;
+}
+
+ArenaCounters ScratchArena::totals() { return {totalAllocations, totalBytes, totalHeapBlocks}; }
@@ -0,0 +1,137 @@
+#include "SessionLog.hpp"
+
+#include <format>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+
+namespace {
+constexpr const char* header = "# geo session 1";
+
+// the names are written last, they may contain spaces
+std::string readName(std::istringstream& line) {
+    std::string name;
+    std::getline(line >> std::ws, name);
+    return name;
+}
+
+// the names of a batch are quoted, they may contain spaces and share the line
+void readNames(std::istringstream& line, SessionAction& action) {
+    while (line.good() && !(line >> std::ws).eof()) {
+        std::string name;
+        if (line >> std::quoted(name)) action.names.push_back(std::move(name));
+    }
+}
+
+// the logs recorded before the Euclidean radius method end before the radius
+void readRadius(std::istringstream& line, SessionAction& action) {
+    if (!(line >> std::ws).eof()) line >> action.radius;
+}
+}  // namespace
+
+void SessionRecorder::start(const std::filesystem::path& path) {
+    stop();
+    m_file.open(path, std::ios::trunc);
+    if (!m_file) throw std::runtime_error(std::format("cannot create {}", path.string()));
+    m_start = std::chrono::steady_clock::now();
+    m_file << header << std::endl;
+}
+
+void SessionRecorder::stop() {
+    if (m_file.is_open()) m_file.close();
+    m_lastPickName.clear();
+    m_lastPickId = -1;
+}
+
+void SessionRecorder::recordOpen(const std::filesystem::path& path, bool reorder) {
+    write(std::format("open {} {}", reorder ? 1 : 0, std::filesystem::absolute(path).string()));
+}
+
+void SessionRecorder::recordPick(const std::string& actorName, vtkIdType pointId) {
+    if (!recording() || (actorName == m_lastPickName && pointId == m_lastPickId)) return;
+    m_lastPickName = actorName;
+    m_lastPickId = pointId;
+    write(std::format("pick {} {}", pointId, actorName));
+}
+
+void SessionRecorder::recordWeight(int method, int ringCount, double alpha, int modes, double radius) {
+    write(std::format("weight {} {} {} {} {}", method, ringCount, alpha, modes, radius));
+}
+
+void SessionRecorder::recordTranslate(int method, int ringCount, double alpha, int modes, double radius,
+                                      double distance) {
+    write(std::format("translate {} {} {} {} {} {}", method, ringCount, alpha, modes, distance, radius));
+}
+
+void SessionRecorder::recordSmooth(const std::string& actorName, int iterations) {
+    write(std::format("smooth {} {}", iterations, actorName));
+}
+
+void SessionRecorder::recordFairing(const std::string& actorName, double stepSize, int weights, bool biLaplacian) {
+    write(std::format("fair {} {} {} {}", stepSize, weights, biLaplacian ? 1 : 0, actorName));
+}
+
+void SessionRecorder::recordBatch(const std::vector<std::string>& actorNames, int operation, int iterations,
+                                  vtkIdType seedPoint, double alpha) {
+    std::ostringstream line;
+    line << std::format("batch {} {} {} {}", operation, iterations, seedPoint, alpha);
+    for (const auto& name : actorNames) line << ' ' << std::quoted(name);
+    write(line.str());
+}
+
+void SessionRecorder::write(const std::string& line) {
+    if (!recording()) return;
+    double time = std::chrono::duration<double>(std::chrono::steady_clock::now() - m_start).count();
+    m_file << std::format("{:.3f} ", time) << line << std::endl;
+}
+
+std::vector<SessionAction> readSessionLog(const std::filesystem::path& path) {
+    std::ifstream file(path);
+    if (!file) throw std::runtime_error(std::format("cannot open {}", path.string()));
+
+    std::vector<SessionAction> actions;
+    std::string text;
+    for (int lineNumber = 1; std::getline(file, text); ++lineNumber) {
+        if (text.empty() || text.front() == '#') continue;
+        std::istringstream line(text);
+        SessionAction action;
+        std::string type;
+        line >> action.time >> type;
+        if (type == "open") {
+            action.type = SessionAction::Type::Open;
+            line >> action.reorder;
+            action.name = readName(line);
+        } else if (type == "pick") {
+            action.type = SessionAction::Type::Pick;
+            line >> action.pointId;
+            action.name = readName(line);
+        } else if (type == "weight") {
+            action.type = SessionAction::Type::Weight;
+            line >> action.method >> action.ringCount >> action.alpha >> action.modes;
+            readRadius(line, action);
+        } else if (type == "translate") {
+            action.type = SessionAction::Type::Translate;
+            line >> action.method >> action.ringCount >> action.alpha >> action.modes >> action.distance;
+            readRadius(line, action);
+        } else if (type == "smooth") {
+            action.type = SessionAction::Type::Smooth;
+            line >> action.iterations;
+            action.name = readName(line);
+        } else if (type == "fair") {
+            action.type = SessionAction::Type::Fair;
+            line >> action.stepSize >> action.weights >> action.biLaplacian;
+            action.name = readName(line);
+        } else if (type == "batch") {
+            action.type = SessionAction::Type::Batch;
+            line >> action.operation >> action.iterations >> action.pointId >> action.alpha;
+            readNames(line, action);
+        } else {
+            line.setstate(std::ios::failbit);
+        }
+        if (line.fail()) {
+            throw std::runtime_error(std::format("{}:{}: malformed session line '{}'", path.string(), lineNumber, text));
+        }
+        actions.push_back(std::move(action));
+    }
+    return actions;
+}
@@ -0,0 +1,283 @@
+#include "SpectralBasis.hpp"
+
+#include <vtkCellArray.h>
+#include <vtkPoints.h>
+#include <vtkSMPTools.h>
+#include <vtkWeakPointer.h>
+
+#include <Eigen/Eigenvalues>
+#include <Eigen/Sparse>
+#include <algorithm>
+#include <cmath>
+#include <format>
+#include <memory_resource>
+#include <mutex>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+#include "MeshGeometry.hpp"
+#include "ScratchArena.hpp"
+#include "memoryUsage.hpp"
+
+namespace {
+// the Lanczos iteration stops when the residuals of the wanted Ritz pairs are below this fraction of their values
+constexpr double lanczosTolerance = 1e-10;
+
+std::size_t lanczosSteps(std::size_t nbPoints, std::size_t nbModes) {
+    return std::min(nbPoints, 2 * nbModes + 40);
+}
+
+/**
+ * Shift-invert Lanczos with full reorthogonalization in the M inner product, on the operator (L - shift M)^-1 M whose
+ * largest eigenvalues 1 / (lambda - shift) are the smallest eigenvalues lambda of L phi = lambda M phi.
+ */
+class ShiftInvertLanczos {
+   public:
+    ShiftInvertLanczos(const Eigen::SparseMatrix<double>& L, const Eigen::VectorXd& mass, double shift)
+        : m_mass(mass) {
+        Eigen::SparseMatrix<double> shifted = L;
+        for (Eigen::Index i = 0; i < mass.size(); ++i) shifted.coeffRef(i, i) -= shift * mass[i];
+        m_solver.compute(shifted);
+        m_shift = shift;
+    }
+
+    bool factorized() const { return m_solver.info() == Eigen::Success; }
+
+    std::size_t factorBytes() const {
+        return m_solver.matrixL().nestedExpression().nonZeros() * (sizeof(double) + sizeof(int)) +
+               m_mass.size() * (sizeof(double) + 2 * sizeof(int));
+    }
+
+    /**
+     * @return the nbModes smallest eigenvalues and their M-orthonormal eigenvectors, in increasing order, fewer when
+     * the Krylov space is exhausted before nbModes steps.
+     */
+    std::pair<Eigen::VectorXd, Eigen::MatrixXd> solve(int nbModes, std::size_t& peakBytes) {
+        using namespace Eigen;
+        const Index n = m_mass.size();
+        const Index maxSteps = static_cast<Index>(lanczosSteps(n, nbModes));
+        MatrixXd Q(n, maxSteps);
+        VectorXd alphas(maxSteps);
+        VectorXd betas(maxSteps);
+        peakBytes = factorBytes() + Q.size() * sizeof(double);
+
+        // a fixed seed, the basis of a mesh does not change from one run to the other
+        std::mt19937_64 generator(0x5eed);
+        std::uniform_real_distribution<double> uniform(-1.0, 1.0);
+        VectorXd q = VectorXd::NullaryExpr(n, [&]() { return uniform(generator); });
+        q /= std::sqrt(q.dot(m_mass.cwiseProduct(q)));
+
+        SelfAdjointEigenSolver<MatrixXd> ritz;
+        Index steps = 0;
+        for (Index j = 0; j < maxSteps; ++j) {
+            Q.col(j) = q;
+            VectorXd w = m_solver.solve(m_mass.cwiseProduct(q));
+            alphas[j] = q.dot(m_mass.cwiseProduct(w));
+            // twice is enough to keep the basis orthogonal to the working precision
+            for (int pass = 0; pass < 2; ++pass) {
+                VectorXd projection = Q.leftCols(j + 1).transpose() * m_mass.cwiseProduct(w);
+                w -= Q.leftCols(j + 1) * projection;
+            }
+            betas[j] = std::sqrt(std::max(0.0, w.dot(m_mass.cwiseProduct(w))));
+            steps = j + 1;
+
+            const bool exhausted = betas[j] <= lanczosTolerance * std::abs(alphas[j]);
+            if (steps >= nbModes && (steps % 10 == 0 || exhausted || steps == maxSteps)) {
+                ritz.compute(tridiagonal(alphas.head(steps), betas.head(steps - 1)));
+                if (exhausted || converged(ritz, betas[j], nbModes)) break;
+            }
+            if (exhausted) break;
+            q = w / betas[j];
+        }
+        if (steps < nbModes) {
+            nbModes = static_cast<int>(steps);
+            ritz.compute(tridiagonal(alphas.head(steps), betas.head(steps - 1)));
+        }
+
+        // the largest Ritz values of the operator are the smallest eigenvalues of the Laplacian
+        VectorXd eigenvalues(nbModes);
+        MatrixXd eigenvectors(n, nbModes);
+        for (int i = 0; i < nbModes; ++i) {
+            const Index r = steps - 1 - i;
+            eigenvalues[i] = m_shift + 1.0 / ritz.eigenvalues()[r];
+            eigenvectors.col(i) = Q.leftCols(steps) * ritz.eigenvectors().col(r);
+        }
+        return {eigenvalues, eigenvectors};
+    }
+
+   private:
+    static Eigen::MatrixXd tridiagonal(const Eigen::VectorXd& alphas, const Eigen::VectorXd& betas) {
+        Eigen::MatrixXd T = alphas.asDiagonal();
+        for (Eigen::Index i = 0; i < betas.size(); ++i) T(i, i + 1) = T(i + 1, i) = betas[i];
+        return T;
+    }
+
+    // the residual of the Ritz pair i is beta times the last component of its eigenvector
+    static bool converged(const Eigen::SelfAdjointEigenSolver<Eigen::MatrixXd>& ritz, double beta, int nbModes) {
+        const Eigen::Index steps = ritz.eigenvalues().size();
+        for (int i = 0; i < nbModes; ++i) {
+            const Eigen::Index r = steps - 1 - i;
+            if (std::abs(beta * ritz.eigenvectors()(steps - 1, r)) > lanczosTolerance * std::abs(ritz.eigenvalues()[r])) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    Eigen::SimplicialLDLT<Eigen::SparseMatrix<double>> m_solver;
+    const Eigen::VectorXd& m_mass;
+    double m_shift = 0.0;
+};
+}  // namespace
+
+SpectralBasis::SpectralBasis(vtkPolyData* mesh, int nbModes) : m_topology(HalfEdgeMesh::get(mesh)) {
+    using namespace Eigen;
+    MemoryScope scope("spectralBasis");
+    auto geometry = MeshGeometry::get(mesh);
+    const Index n = m_topology->numberOfVertices();
+    m_requestedModes = nbModes;
+    if (n == 0) {
+        m_error = "the mesh is empty";
+        return;
+    }
+    nbModes = static_cast<int>(std::clamp<Index>(nbModes, 1, n));
+
+    std::pmr::vector<Triplet<double>> triplets(ScratchArena::resource());
+    geometry->cotangentStiffness(triplets);
+    VectorXd mass(n);
+    for (Index i = 0; i < n; ++i) mass[i] = geometry->vertexArea(i);
+    double scale = 0.0;
+    for (const auto& triplet : triplets) {
+        if (triplet.row() == triplet.col()) scale += triplet.value();
+    }
+    const double meanArea = mass.sum() / static_cast<double>(n);
+    scale /= mass.sum();
+    // points outside of the faces are pinned with a stiffness far above the spectrum, instead of adding modes of
+    // eigenvalue 0 localized on them
+    for (Index i = 0; i < n; ++i) {
+        if (m_topology->outgoing(i).empty()) {
+            mass[i] = meanArea;
+            triplets.emplace_back(i, i, 1e6 * scale * meanArea);
+        }
+    }
+    SparseMatrix<double> L(n, n);
+    L.setFromTriplets(triplets.begin(), triplets.end());
+    std::size_t matrixBytes = L.nonZeros() * (sizeof(double) + sizeof(int)) + (n + 1) * sizeof(int);
+    MemoryScope::observe(containerBytes(triplets) + matrixBytes);
+    triplets = std::pmr::vector<Triplet<double>>(ScratchArena::resource());
+
+    m_meanEdgeLength = geometry->meanEdgeLength(mesh->GetPoints());
+
+    // a small negative shift makes L - shift M definite, L alone is singular on the constants
+    ShiftInvertLanczos lanczos(L, mass, -1e-6 * scale);
+    if (!lanczos.factorized()) {
+        m_error = "cannot factorize the shifted Laplacian";
+        return;
+    }
+    std::size_t lanczosBytes = 0;
+    auto [eigenvalues, eigenvectors] = lanczos.solve(nbModes, lanczosBytes);
+    MemoryScope::observe(matrixBytes + lanczosBytes + 2 * eigenvectors.size() * sizeof(double));
+    m_eigenvalues = std::move(eigenvalues);
+    m_modes = eigenvectors;
+}
+
+std::size_t SpectralBasis::memoryBytes() const { return (m_eigenvalues.size() + m_modes.size()) * sizeof(double); }
+
+std::size_t SpectralBasis::predictBytes(vtkPolyData* mesh, int nbModes) {
+    std::size_t nbPoints = mesh->GetNumberOfPoints();
+    std::size_t nbModesUsed = std::min<std::size_t>(std::max(nbModes, 1), nbPoints);
+    std::size_t nonZeros = MeshGeometry::predictStiffnessNonZeros(mesh);
+    std::size_t matrixBytes = nonZeros * (sizeof(double) + sizeof(int)) + (nbPoints + 1) * sizeof(int);
+    std::size_t factorBytes = MeshGeometry::ldltFillFactor * matrixBytes;
+    std::size_t krylovBytes = nbPoints * lanczosSteps(nbPoints, nbModesUsed) * sizeof(double);
+    return matrixBytes + factorBytes + krylovBytes + 2 * nbPoints * nbModesUsed * sizeof(double);
+}
+
+Eigen::VectorXd SpectralBasis::heatCoefficients(vtkIdType ptId, double time, int k) const {
+    return (-time * m_eigenvalues.head(k)).array().exp() * m_modes.row(ptId).head(k).transpose().array();
+}
+
+std::function<double(vtkIdType)> SpectralBasis::heatKernel(vtkIdType ptId, double time, int nbModes) const {
+    const int k = nbModes > 0 ? std::min(nbModes, numberOfModes()) : numberOfModes();
+    if (k == 0) return [](vtkIdType) { return 0.0; };
+    return [basis = shared_from_this(), coefficients = heatCoefficients(ptId, time, k)](vtkIdType v) {
+        return basis->m_modes.row(v).head(coefficients.size()).dot(coefficients);
+    };
+}
+
+void SpectralBasis::heatKernel(vtkIdType ptId, double time, int nbModes, std::span<float> values) const {
+    const int k = nbModes > 0 ? std::min(nbModes, numberOfModes()) : numberOfModes();
+    if (k == 0) {
+        std::fill(values.begin(), values.end(), 0.0f);
+        return;
+    }
+    const Eigen::VectorXd coefficients = heatCoefficients(ptId, time, k);
+    vtkSMPTools::For(0, static_cast<vtkIdType>(values.size()), [&](vtkIdType begin, vtkIdType end) {
+        for (vtkIdType v = begin; v < end; ++v) {
+            values[v] = static_cast<float>(m_modes.row(v).head(k).dot(coefficients));
+        }
+    });
+}
+
+namespace {
+struct CacheEntry {
+    vtkWeakPointer<vtkPolyData> mesh;
+    vtkPoints* points;
+    vtkMTimeType mtime;
+    const HalfEdgeMesh* topology;
+    std::shared_ptr<const SpectralBasis> basis;
+};
+std::mutex cacheMutex;
+std::unordered_map<vtkPolyData*, CacheEntry> cache;
+
+std::shared_ptr<const SpectralBasis> findLocked(vtkPolyData* mesh) {
+    std::erase_if(cache, [](const auto& entry) { return entry.second.mesh == nullptr; });
+    if (auto search = cache.find(mesh); search != cache.end()) {
+        auto& entry = search->second;
+        if (entry.points == mesh->GetPoints() && entry.mtime == mesh->GetPoints()->GetMTime() &&
+            HalfEdgeMesh::find(mesh).get() == entry.topology) {
+            return entry.basis;
+        }
+    }
+    return nullptr;
+}
+}  // namespace
+
+std::shared_ptr<const SpectralBasis> SpectralBasis::find(vtkPolyData* mesh) {
+    std::lock_guard lock(cacheMutex);
+    return findLocked(mesh);
+}
+
+std::shared_ptr<const SpectralBasis> SpectralBasis::get(vtkPolyData* mesh, int nbModes) {
+    {
+        std::lock_guard lock(cacheMutex);
+        auto basis = findLocked(mesh);
+        if (basis != nullptr && basis->requestedModes() >= std::min<vtkIdType>(nbModes, mesh->GetNumberOfPoints())) {
+            return basis;
+        }
+    }
+    auto basis = std::make_shared<const SpectralBasis>(mesh, nbModes);
+    std::lock_guard lock(cacheMutex);
+    cache[mesh] = {mesh, mesh->GetPoints(), mesh->GetPoints()->GetMTime(), basis->m_topology.get(), basis};
+    return basis;
+}
+
+namespace {
+double diffusionTime(const SpectralBasis& basis, double alpha, int iterations) {
+    const double h = basis.meanEdgeLength();
+    return alpha * iterations * h * h / 4.0;
+}
+}  // namespace
+
+std::function<double(vtkIdType)> spectralDiffusion(vtkPolyData* mesh, vtkIdType ptId, double alpha, int iterations,
+                                                   int nbModes) {
+    auto basis = SpectralBasis::get(mesh, nbModes);
+    return basis->heatKernel(ptId, diffusionTime(*basis, alpha, iterations), nbModes);
+}
+
+void spectralDiffusion(vtkPolyData* mesh, vtkIdType ptId, double alpha, int iterations, int nbModes,
+                       std::span<float> values) {
+    auto basis = SpectralBasis::get(mesh, nbModes);
+    basis->heatKernel(ptId, diffusionTime(*basis, alpha, iterations), nbModes, values);
+}
@@ -0,0 +1,43 @@
+#include "ThreadPool.hpp"
+
+#include <algorithm>
+
+ThreadPool::ThreadPool(unsigned nbThreads) {
+    nbThreads = std::max(1u, nbThreads);
+    m_workers.reserve(nbThreads);
+    for (unsigned i = 0; i < nbThreads; ++i) {
+        m_workers.emplace_back([this](std::stop_token stopToken) { work(stopToken); });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard lock(m_mutex);
+        m_tasks.clear();
+    }
+    for (auto& worker : m_workers) {
+        worker.request_stop();
+    }
+    // the jthreads are joined by their destructors
+}
+
+void ThreadPool::submit(std::function<void()> task) {
+    {
+        std::lock_guard lock(m_mutex);
+        m_tasks.push_back(std::move(task));
+    }
+    m_condition.notify_one();
+}
+
+void ThreadPool::work(std::stop_token stopToken) {
+    while (!stopToken.stop_requested()) {
+        std::function<void()> task;
+        {
+            std::unique_lock lock(m_mutex);
+            if (!m_condition.wait(lock, stopToken, [this] { return !m_tasks.empty(); })) return;
+            task = std::move(m_tasks.front());
+            m_tasks.pop_front();
+        }
+        task();
+    }
+}
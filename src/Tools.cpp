@@ -4,20 +4,46 @@
 #include <vtkActor.h>
 #include <vtkDataArray.h>
 #include <vtkDataSet.h>
+#include <vtkMapper.h>
 #include <vtkPointData.h>
 #include <vtkPolyData.h>
 #include <vtkPolyDataMapper.h>
 #include <vtkProperty.h>
 #include <vtkType.h>
-#include <vtkUnsignedCharArray.h>
 
+#include <algorithm>
+#include <array>
+#include <chrono>
 #include <format>
+#include <functional>
+#include <stdexcept>
 
+#include "PartialUploadPolyDataMapper.hpp"
+#include "ScratchArena.hpp"
+#include "SpectralBasis.hpp"
+#include "colorize.hpp"
 #include "deformations.hpp"
 #include "harmonicFn.hpp"
+#include "memoryUsage.hpp"
+#include "meshReorder.hpp"
+#include "meshSharing.hpp"
 
-Tools::Tools(vtkRenderer* renderer, MouseInteractorStylePP* picker, bool* picking)
-    : m_renderer(renderer), m_picker(picker), m_picking(picking) {}
+namespace {
+double toMiB(std::size_t bytes) { return static_cast<double>(bytes) / (1024.0 * 1024.0); }
+
+void markPointsModified(vtkActor* actor, PointRange range) {
+    if (auto mapper = PartialUploadPolyDataMapper::SafeDownCast(actor->GetMapper())) {
+        mapper->addModifiedPoints(range.begin, range.end);
+    }
+}
+
+void markPointsModified(vtkActor* actor, const std::vector<PointRange>& ranges) {
+    for (auto range : ranges) markPointsModified(actor, range);
+}
+}  // namespace
+
+Tools::Tools(vtkRenderer* renderer, MouseInteractorStylePP* picker, bool* picking, SessionRecorder* recorder)
+    : m_picking(picking), m_recorder(recorder), m_renderer(renderer), m_picker(picker) {}
 
 void Tools::showWindows() {
     if (m_showActorsWindow) actorListWindow();
@@ -31,9 +57,17 @@ void Tools::enableDeformWindow() { m_showDeformWindow = true; }
 
 void Tools::cleanup() {
     if (m_toRemove != nullptr) {
+        m_batchActors.erase(m_toRemove);
         m_renderer->RemoveActor(m_toRemove);
         m_toRemove = nullptr;
     }
+    m_batch.applyFinished();
+}
+
+vtkActor* Tools::selectedActor() const {
+    auto actors = m_renderer->GetActors();
+    if (m_selectedActor >= actors->GetNumberOfItems()) return nullptr;
+    return vtkActor::SafeDownCast(actors->GetItemAsObject(m_selectedActor));
 }
 
 void Tools::actorListWindow() {
@@ -46,6 +80,15 @@ void Tools::actorListWindow() {
 
             for (int i = 0; i < num_items; ++i) {
                 auto actor = dynamic_cast<vtkActor*>(actors->GetItemAsObject(i));
+                bool inBatch = m_batchActors.contains(actor);
+                if (ImGui::Checkbox(std::format("##batch{}", i).c_str(), &inBatch)) {
+                    if (inBatch) {
+                        m_batchActors.insert(actor);
+                    } else {
+                        m_batchActors.erase(actor);
+                    }
+                }
+                ImGui::SameLine();
                 const std::string label = std::format("{}: {}", i, actor->GetObjectName());
                 if (ImGui::Selectable(label.c_str(), m_selectedActor == i)) {
                     m_selectedActor = i;
@@ -78,31 +121,161 @@ void Tools::actorListWindow() {
                     if (ImGui::Button("Remove")) {
                         m_toRemove = actor;
                     }
+                    ImGui::Separator();
+                    memorySection(actor);
                 }
             }
+            ImGui::Separator();
+            batchSection();
             ImGui::EndChild();
             ImGui::EndGroup();
         }
     }
 }
 
-void colorizeMesh(vtkPolyData* polyData, float* color) {
-    if (polyData->GetNumberOfVerts() != polyData->GetNumberOfPoints()) {
-        vtkNew<vtkCellArray> vertices;
-        for (vtkIdType i = 0; i < polyData->GetNumberOfPoints(); ++i) {
-            vertices->InsertNextCell(1);
-            vertices->InsertCellPoint(i);
+void Tools::memorySection(vtkActor* actor) {
+    if (auto polyData = vtkPolyData::SafeDownCast(actor->GetMapper()->GetInput())) {
+        ImGui::Text("Arrays: %.2f MiB%s", toMiB(meshArraysBytes(polyData)),
+                    sharesPoints(polyData) ? ", points shared with another actor" : "");
+        ImGui::Text("Caches: %.2f MiB", toMiB(meshCachesBytes(polyData)));
+    }
+    auto last = lastOperationMemory();
+    if (!last.name.empty()) {
+        ImGui::Text("Last operation: %s, peak %.2f MiB", last.name.c_str(), toMiB(last.peakBytes));
+        ImGui::Text("Scratch arena: %zu allocations, %.2f MiB, %zu heap blocks", last.arena.allocations,
+                    toMiB(last.arena.bytes), last.arena.heapBlocks);
+    }
+    auto arena = ScratchArena::totals();
+    ImGui::Text("Scratch arena since start: %zu allocations, %zu heap blocks", arena.allocations, arena.heapBlocks);
+    if (m_memoryCeilingMiB < 0) m_memoryCeilingMiB = 0;
+    if (ImGui::InputInt("Memory Ceiling (MiB, 0 = none)", &m_memoryCeilingMiB)) {
+        setMemoryCeiling(static_cast<std::size_t>(m_memoryCeilingMiB) * 1024 * 1024);
+    }
+}
+
+std::size_t Tools::predictWeightingBytes(vtkPolyData* polyData) {
+    if (m_weightingMethod == 0) {
+        return predictSimpleHarmonicBytes(polyData, m_ringCount);
+    } else if (m_weightingMethod == 1) {
+        return predictLaplacianDiffusionBytes(polyData);
+    } else if (m_weightingMethod == 2) {
+        return predictSolveLaplaceBytes(polyData, m_ringCount);
+    } else if (m_weightingMethod == 3) {
+        return predictSpectralDiffusionBytes(polyData, m_spectralModes);
+    } else {
+        return predictRadiusFalloffBytes(polyData);
+    }
+}
+
+WeightParameters Tools::weightParameters(vtkPolyData* polyData, vtkIdType pointId) const {
+    return {polyData, pointId, m_weightingMethod, m_ringCount, m_alpha, m_spectralModes, m_radius,
+            polyData->GetPoints()->GetMTime()};
+}
+
+void Tools::progressiveSection(vtkActor* actor, vtkPolyData* polyData, vtkIdType pointId) {
+    // nothing is computed before the first Apply, then the field follows the pick and the parameters
+    if (!m_progressiveWeights.running() && !m_progressiveWeights.finished()) return;
+    if (m_batch.processes(polyData)) return;
+    auto parameters = weightParameters(polyData, pointId);
+    if (!m_progressiveWeights.computes(parameters)) {
+        if (!allowOperation(predictWeightingBytes(polyData))) {
+            m_progressiveWeights.stop();
+            return;
+        }
+        m_progressiveWeights.start(parameters);
+    }
+    bool wasRunning = m_progressiveWeights.running();
+    if (m_progressiveWeights.refine(std::chrono::duration<double, std::milli>(m_frameBudgetMs))) {
+        colorizeWeights(polyData, pointId, m_progressiveWeights.weights(), m_colorNeutral, m_colorStart, m_colorEnd);
+    }
+    if (wasRunning && m_progressiveWeights.finished()) {
+        // only the fields computed to the end are replayed
+        m_recorder->recordPick(actor->GetObjectName(), pointId);
+        m_recorder->recordWeight(m_weightingMethod, m_ringCount, m_alpha, m_spectralModes, m_radius);
+    }
+    const std::string label = m_progressiveWeights.finished() ? "Refined" : "Refining";
+    ImGui::ProgressBar(static_cast<float>(m_progressiveWeights.progress()), ImVec2(-1.0f, 0.0f), label.c_str());
+}
+
+bool Tools::allowOperation(std::size_t predictedBytes) {
+    if (exceedsMemoryCeiling(predictedBytes)) {
+        m_memoryWarning = std::format("Refused: {:.1f} MiB predicted, ceiling is {:.1f} MiB", toMiB(predictedBytes),
+                                      toMiB(memoryCeiling()));
+        return false;
+    }
+    m_memoryWarning.clear();
+    return true;
+}
+
+void Tools::batchSection() {
+    if (!ImGui::CollapsingHeader("Batch")) return;
+    ImGui::Text("%zu actors selected", m_batchActors.size());
+    std::array<const char*, 2> operations = {"Laplacian Smoothing", "Laplacian Diffusion"};
+    ImGui::Combo("Operation", &m_batchOperation, operations.begin(), operations.size());
+    if (m_batchOperation == 0) {
+        if (m_smoothingIterations < 1) m_smoothingIterations = 1;
+        ImGui::InputInt("Iterations", &m_smoothingIterations);
+    } else {
+        if (m_batchSeed < 0) m_batchSeed = 0;
+        ImGui::InputInt("Seed Point", &m_batchSeed);
+        if (m_ringCount < 0) m_ringCount = 0;
+        ImGui::InputInt("Iterations", &m_ringCount);
+        if (m_alpha < 0.0) m_alpha = 0.0;
+        if (m_alpha >= 0.5) m_alpha = 0.49;
+        ImGui::InputFloat("Alpha", &m_alpha);
+    }
+
+    ImGui::BeginDisabled(m_batch.running() || m_batchActors.empty());
+    if (ImGui::Button("Run")) {
+        std::vector<std::pair<std::string, vtkPolyData*>> meshes;
+        std::vector<std::size_t> predictions;
+        for (auto actor : m_batchActors) {
+            if (auto polyData = vtkPolyData::SafeDownCast(actor->GetMapper()->GetInput())) {
+                meshes.emplace_back(actor->GetObjectName(), polyData);
+                // the working copy of the mesh and the temporaries of the operation
+                predictions.push_back(meshArraysBytes(polyData) +
+                                      (m_batchOperation == 0 ? predictLaplacianSmoothingBytes(polyData)
+                                                             : predictLaplacianDiffusionBytes(polyData)));
+            }
+        }
+        // the largest meshes run at the same time, one per worker
+        std::ranges::sort(predictions, std::greater());
+        std::size_t concurrent = 0;
+        for (std::size_t i = 0; i < std::min<std::size_t>(predictions.size(), m_batch.concurrency()); ++i) {
+            concurrent += predictions[i];
+        }
+        if (allowOperation(concurrent)) {
+            if (m_batchOperation == 0) {
+                m_batch.run(meshes, [iterations = m_smoothingIterations](vtkPolyData* mesh, const auto& progress) {
+                    laplacianSmoothing(mesh, iterations, progress);
+                });
+            } else {
+                std::array<float, 3> neutral = {m_colorNeutral[0], m_colorNeutral[1], m_colorNeutral[2]};
+                std::array<float, 3> start = {m_colorStart[0], m_colorStart[1], m_colorStart[2]};
+                std::array<float, 3> end = {m_colorEnd[0], m_colorEnd[1], m_colorEnd[2]};
+                m_batch.run(meshes, [=, seed = m_batchSeed, alpha = m_alpha, iterations = m_ringCount](
+                                        vtkPolyData* mesh, const auto& progress) {
+                    vtkIdType pointId = std::min<vtkIdType>(seed, mesh->GetNumberOfPoints() - 1);
+                    if (pointId < 0) return;
+                    auto weights = weightingValues(1, mesh, pointId, iterations, alpha, 0, 0.0, progress);
+                    colorizeWeights(mesh, pointId, weights, neutral.data(), start.data(), end.data());
+                });
+            }
+            std::vector<std::string> names;
+            for (const auto& [name, mesh] : meshes) names.push_back(name);
+            m_recorder->recordBatch(names, m_batchOperation,
+                                    m_batchOperation == 0 ? m_smoothingIterations : m_ringCount, m_batchSeed, m_alpha);
         }
-        polyData->SetVerts(vertices);
     }
-    vtkNew<vtkUnsignedCharArray> colors;
-    colors->SetNumberOfComponents(3);
-    colors->SetName("Colors");
+    ImGui::EndDisabled();
+    if (!m_memoryWarning.empty()) ImGui::TextColored(ImVec4(1.0f, 0.4f, 0.4f, 1.0f), "%s", m_memoryWarning.c_str());
 
-    for (vtkIdType i = 0; i < polyData->GetNumberOfPoints(); ++i) {
-        colors->InsertNextTuple3(color[0] * 255, color[1] * 255, color[2] * 255);
+    for (const auto& job : m_batch.jobs()) {
+        const std::string label =
+            job->done ? std::format("{}: {:.3f} s, peak {:.1f} MiB", job->name, job->seconds, toMiB(job->peakBytes))
+                      : job->name;
+        ImGui::ProgressBar(static_cast<float>(job->progress), ImVec2(-1.0f, 0.0f), label.c_str());
     }
-    polyData->GetPointData()->SetScalars(colors);
 }
 
 void Tools::functionsWindow() {
@@ -128,7 +301,9 @@ void Tools::functionsWindow() {
 
             if (pointId && data) {
                 double* point = (*data)->GetPoint(*pointId);
-                ImGui::Text("Picked Point %lld : %lf %lf %lf", *pointId, point[0], point[1], point[2]);
+                // the id in the loaded file, the mesh may have been reordered
+                ImGui::Text("Picked Point %lld : %lf %lf %lf", originalPointId(*data, *pointId), point[0], point[1],
+                            point[2]);
             }
             if (actor) {
                 ImGui::Text("Actor : %s", (*actor)->GetObjectName().c_str());
@@ -136,20 +311,43 @@ void Tools::functionsWindow() {
 
             ImGui::Separator();
             ImGui::Text("Weight Function");
-            std::array<const char*, 3> styles = {"Simple Harmonic", "Laplacian Diffusion", "Solving Laplace Equations"};
+            std::array<const char*, 5> styles = {"Simple Harmonic", "Laplacian Diffusion", "Solving Laplace Equations",
+                                                 "Spectral Diffusion", "Euclidean Radius"};
 
             ImGui::Combo("Weighting Method", &m_weightingMethod, styles.begin(), styles.size());
 
             if (m_weightingMethod == 0 || m_weightingMethod == 2) {
                 if (m_ringCount < 1) m_ringCount = 1;
                 ImGui::InputInt("Ring Count", &m_ringCount);
-            } else if (m_weightingMethod == 1) {
+            } else if (m_weightingMethod == 4) {
+                if (m_radius < 0.0) m_radius = 0.0;
+                ImGui::InputFloat("Radius", &m_radius);
+            } else {
                 if (m_ringCount < 0) m_ringCount = 0;
                 ImGui::InputInt("Iterations", &m_ringCount);
                 if (m_alpha < 0.0) m_alpha = 0.0;
                 if (m_alpha >= 0.5) m_alpha = 0.49;
                 ImGui::InputFloat("Alpha", &m_alpha);
             }
+            if (m_weightingMethod == 3) {
+                if (m_spectralModes < 1) m_spectralModes = 1;
+                ImGui::InputInt("Modes", &m_spectralModes);
+                if (data && *data) {
+                    // the basis is computed once per mesh, the following weights are truncated sums over the modes
+                    auto basis = SpectralBasis::find(*data);
+                    ImGui::Text("Basis: %d modes", basis ? basis->numberOfModes() : 0);
+                    ImGui::SameLine();
+                    if (ImGui::Button("Precompute") &&
+                        allowOperation(predictSpectralDiffusionBytes(*data, m_spectralModes))) {
+                        SpectralBasis::get(*data, m_spectralModes);
+                    }
+                    // the failed basis stays cached until the mesh changes, its weights are all 0
+                    if (basis && !basis->error().empty()) {
+                        ImGui::TextColored(ImVec4(1.0f, 0.4f, 0.4f, 1.0f), "Spectral basis failed: %s",
+                                           basis->error().c_str());
+                    }
+                }
+            }
 
             ImGui::Separator();
             ImGui::Text("Color Transformation");
@@ -161,29 +359,33 @@ void Tools::functionsWindow() {
             if (actor && data && pointId) {
                 auto polyData = *data;
                 auto originActor = *actor;
-                if (ImGui::Button("Apply")) {
-                    colorizeMesh(polyData, m_colorNeutral);
-                    std::function<double(vtkIdType)> harmonic = [](vtkIdType) -> double { return 0.0; };
-                    if (m_weightingMethod == 0) {
-                        harmonic = simpleHarmonic(polyData, *pointId, m_ringCount);
-                    } else if (m_weightingMethod == 1) {
-                        harmonic = laplacianDiffusion(polyData, *pointId, m_alpha, m_ringCount);
+                ImGui::Checkbox("Progressive", &m_progressive);
+                if (m_progressive) {
+                    if (m_frameBudgetMs < 1.0f) m_frameBudgetMs = 1.0f;
+                    ImGui::InputFloat("Frame Budget (ms)", &m_frameBudgetMs);
+                }
+                // the mesh is replaced by the result of the batch, it must not be modified until then
+                ImGui::BeginDisabled(m_batch.processes(polyData));
+                if (ImGui::Button("Apply") && allowOperation(predictWeightingBytes(polyData))) {
+                    if (m_progressive) {
+                        m_progressiveWeights.start(weightParameters(polyData, *pointId));
                     } else {
-                        harmonic = solveLaplace(polyData, *pointId, m_ringCount);
-                    }
-
-                    double max = harmonic(*pointId);
-                    for (vtkIdType ptid = 0; ptid < polyData->GetNumberOfPoints(); ++ptid) {
-                        double weight = harmonic(ptid);
-                        double normalized = weight / max;
-                        if (weight > 0.0) {
-                            double r = 255.0 * (normalized * m_colorStart[0] + (1.0 - normalized) * m_colorEnd[0]);
-                            double g = 255.0 * (normalized * m_colorStart[1] + (1.0 - normalized) * m_colorEnd[1]);
-                            double b = 255.0 * (normalized * m_colorStart[2] + (1.0 - normalized) * m_colorEnd[2]);
-                            polyData->GetPointData()->GetScalars()->SetTuple3(ptid, r, g, b);
-                        }
+                        m_recorder->recordPick(originActor->GetObjectName(), *pointId);
+                        m_recorder->recordWeight(m_weightingMethod, m_ringCount, m_alpha, m_spectralModes, m_radius);
+                        auto weights = weightingValues(m_weightingMethod, polyData, *pointId, m_ringCount, m_alpha,
+                                                       m_spectralModes, m_radius);
+                        colorizeWeights(polyData, *pointId, weights, m_colorNeutral, m_colorStart, m_colorEnd);
                     }
                 }
+                ImGui::EndDisabled();
+                if (m_progressive) {
+                    progressiveSection(originActor, polyData, *pointId);
+                } else {
+                    m_progressiveWeights.stop();
+                }
+                if (!m_memoryWarning.empty()) {
+                    ImGui::TextColored(ImVec4(1.0f, 0.4f, 0.4f, 1.0f), "%s", m_memoryWarning.c_str());
+                }
             }
         }
     }
@@ -216,32 +418,71 @@ void Tools::deformWindow() {
 
             ImGui::Separator();
             ImGui::Text("Laplacian Smoothing");
-            if (m_smoothingIterations < 1) m_smoothingIterations = 1;
-            ImGui::InputInt("Iterations", &m_smoothingIterations);
+            std::array<const char*, 2> modes = {"Explicit", "Implicit Fairing"};
+            ImGui::Combo("Mode", &m_smoothingMode, modes.begin(), modes.size());
+            if (m_smoothingMode == 0) {
+                if (m_smoothingIterations < 1) m_smoothingIterations = 1;
+                ImGui::InputInt("Iterations", &m_smoothingIterations);
+            } else {
+                if (m_fairingStep < 0.0f) m_fairingStep = 0.0f;
+                ImGui::InputFloat("Step Size", &m_fairingStep);
+                std::array<const char*, 2> weights = {"Uniform", "Cotangent"};
+                ImGui::Combo("Weights", &m_fairingWeights, weights.begin(), weights.size());
+                ImGui::Checkbox("Bi-Laplacian", &m_fairingBiLaplacian);
+            }
+            ImGui::BeginDisabled(*data && m_batch.processes(*data));
             if (*data) {
-                if (ImGui::Button("Apply")) {
-                    laplacianSmoothing(*data, m_smoothingIterations);
+                if (m_smoothingMode == 0) {
+                    if (ImGui::Button("Apply") && allowOperation(predictLaplacianSmoothingBytes(*data))) {
+                        m_recorder->recordSmooth((*actor)->GetObjectName(), m_smoothingIterations);
+                        markPointsModified(*actor, laplacianSmoothing(*data, m_smoothingIterations));
+                    }
+                } else {
+                    auto weights = static_cast<FairingWeights>(m_fairingWeights);
+                    if (ImGui::Button("Apply") &&
+                        allowOperation(
+                            predictImplicitFairingBytes(*data, m_fairingStep, weights, m_fairingBiLaplacian))) {
+                        m_recorder->recordFairing((*actor)->GetObjectName(), m_fairingStep, m_fairingWeights,
+                                                  m_fairingBiLaplacian);
+                        // a singular operator is reported in the window, the mesh is left unchanged
+                        try {
+                            markPointsModified(*actor,
+                                               implicitFairing(*data, m_fairingStep, weights, m_fairingBiLaplacian));
+                            m_deformError.clear();
+                        } catch (const std::runtime_error& e) {
+                            m_deformError = std::format("Fairing failed: {}", e.what());
+                        }
+                    }
                 }
             }
             ImGui::Separator();
             ImGui::Text("Translation");
-            std::array<const char*, 3> styles = {"Simple Harmonic", "Laplacian Diffusion", "Solving Laplace Equations"};
+            std::array<const char*, 5> styles = {"Simple Harmonic", "Laplacian Diffusion", "Solving Laplace Equations",
+                                                 "Spectral Diffusion", "Euclidean Radius"};
             ImGui::Combo("Weighting Method", &m_weightingMethod, styles.begin(), styles.size());
             ImGui::InputFloat("Distance", &m_deformDistance);
-            ImGui::InputInt("Ring Count", &m_ringCount);
-
-            std::function<double(vtkIdType)> harmonic = [](vtkIdType) -> double { return 0.0; };
-
-            if (ImGui::Button("OK")) {
-                if (m_weightingMethod == 0) {
-                    harmonic = simpleHarmonic(*data, *pointId, m_ringCount);
-                } else if (m_weightingMethod == 1) {
-                    harmonic = laplacianDiffusion(*data, *pointId, m_alpha, m_ringCount);
-                } else {
-                    harmonic = solveLaplace(*data, *pointId, m_ringCount);
-                }
+            if (m_weightingMethod == 4) {
+                if (m_radius < 0.0) m_radius = 0.0;
+                ImGui::InputFloat("Radius", &m_radius);
+            } else {
+                ImGui::InputInt("Ring Count", &m_ringCount);
+            }
 
-                weightedTranslate(*data, *pointId, m_deformDistance, harmonic);
+            if (ImGui::Button("OK") && allowOperation(predictWeightingBytes(*data))) {
+                m_recorder->recordPick((*actor)->GetObjectName(), *pointId);
+                m_recorder->recordTranslate(m_weightingMethod, m_ringCount, m_alpha, m_spectralModes, m_radius,
+                                            m_deformDistance);
+                auto harmonic = weightingFunction(m_weightingMethod, *data, *pointId, m_ringCount, m_alpha,
+                                                  m_spectralModes, m_radius);
+                auto support = weightingSupport(m_weightingMethod, *data, *pointId, m_ringCount, m_radius);
+                markPointsModified(*actor, weightedTranslate(*data, *pointId, m_deformDistance, harmonic, support));
+            }
+            ImGui::EndDisabled();
+            if (!m_memoryWarning.empty()) {
+                ImGui::TextColored(ImVec4(1.0f, 0.4f, 0.4f, 1.0f), "%s", m_memoryWarning.c_str());
+            }
+            if (!m_deformError.empty()) {
+                ImGui::TextColored(ImVec4(1.0f, 0.4f, 0.4f, 1.0f), "%s", m_deformError.c_str());
             }
         }
     }
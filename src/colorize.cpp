@@ -0,0 +1,106 @@
+#include "colorize.hpp"
+
+#include <vtkCellArray.h>
+#include <vtkIdTypeArray.h>
+#include <vtkNew.h>
+#include <vtkPointData.h>
+#include <vtkSMPTools.h>
+#include <vtkUnsignedCharArray.h>
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <numeric>
+#include <vector>
+
+namespace {
+// levels of the gradient between colorEnd and colorStart, finer than the 256 values of a color component
+constexpr int gradientLevels = 1024;
+
+void addVertexCells(vtkPolyData* polyData) {
+    const vtkIdType nbPoints = polyData->GetNumberOfPoints();
+    if (polyData->GetNumberOfVerts() == nbPoints) return;
+    // one cell per point, the arrays are written directly instead of inserting the cells one by one
+    vtkNew<vtkIdTypeArray> offsets;
+    offsets->SetNumberOfValues(nbPoints + 1);
+    std::iota(offsets->GetPointer(0), offsets->GetPointer(0) + nbPoints + 1, 0);
+    vtkNew<vtkIdTypeArray> connectivity;
+    connectivity->SetNumberOfValues(nbPoints);
+    std::iota(connectivity->GetPointer(0), connectivity->GetPointer(0) + nbPoints, 0);
+    vtkNew<vtkCellArray> vertices;
+    vertices->SetData(offsets, connectivity);
+    polyData->SetVerts(vertices);
+}
+
+vtkUnsignedCharArray* colorArray(vtkPolyData* polyData) {
+    const vtkIdType nbPoints = polyData->GetNumberOfPoints();
+    // the colors of an earlier call are overwritten in place, unless another mesh shares them
+    auto colors = vtkUnsignedCharArray::SafeDownCast(polyData->GetPointData()->GetScalars());
+    if (colors != nullptr && colors->GetNumberOfComponents() == 3 && colors->GetNumberOfTuples() == nbPoints &&
+        colors->GetReferenceCount() == 1) {
+        return colors;
+    }
+    vtkNew<vtkUnsignedCharArray> created;
+    created->SetNumberOfComponents(3);
+    created->SetName("Colors");
+    created->SetNumberOfTuples(nbPoints);
+    polyData->GetPointData()->SetScalars(created);
+    return created;
+}
+
+unsigned char toByte(float value) { return static_cast<unsigned char>(std::clamp(value, 0.0f, 255.0f)); }
+}  // namespace
+
+void colorizeMesh(vtkPolyData* polyData, const float* color) {
+    addVertexCells(polyData);
+    auto colors = colorArray(polyData);
+    const unsigned char rgb[3] = {toByte(color[0] * 255), toByte(color[1] * 255), toByte(color[2] * 255)};
+    unsigned char* tuples = colors->GetPointer(0);
+    vtkSMPTools::For(0, polyData->GetNumberOfPoints(), [&](vtkIdType begin, vtkIdType end) {
+        for (vtkIdType i = begin; i < end; ++i) {
+            std::copy(rgb, rgb + 3, tuples + 3 * i);
+        }
+    });
+    colors->Modified();
+}
+
+void colorizeWeights(vtkPolyData* polyData, vtkIdType pointId, std::span<const float> weights,
+                     const float* colorNeutral, const float* colorStart, const float* colorEnd) {
+    const vtkIdType nbPoints = polyData->GetNumberOfPoints();
+    if (static_cast<vtkIdType>(weights.size()) != nbPoints || pointId < 0 || pointId >= nbPoints) return;
+    addVertexCells(polyData);
+    auto colors = colorArray(polyData);
+
+    // the gradient is interpolated once per level rather than once per point, the neutral color comes first
+    std::array<std::array<unsigned char, 3>, gradientLevels + 1> palette;
+    palette[0] = {toByte(colorNeutral[0] * 255), toByte(colorNeutral[1] * 255), toByte(colorNeutral[2] * 255)};
+    for (int level = 0; level < gradientLevels; ++level) {
+        float normalized = static_cast<float>(level) / (gradientLevels - 1);
+        for (int c = 0; c < 3; ++c) {
+            palette[level + 1][c] = toByte(255 * (normalized * colorStart[c] + (1 - normalized) * colorEnd[c]));
+        }
+    }
+
+    // the normalization reads the weight of the picked point once, the buffer itself is read by the single pass
+    const float max = weights[pointId];
+    const float scale = max > 0.0f ? (gradientLevels - 1) / max : 0.0f;
+    unsigned char* tuples = colors->GetPointer(0);
+    const float* weight = weights.data();
+    vtkSMPTools::For(0, nbPoints, [&](vtkIdType begin, vtkIdType end) {
+        for (vtkIdType i = begin; i < end; ++i) {
+            const float level = std::min(weight[i] * scale, static_cast<float>(gradientLevels - 1));
+            const int index = weight[i] > 0.0f ? 1 + static_cast<int>(level) : 0;
+            std::memcpy(tuples + 3 * i, palette[index].data(), 3);
+        }
+    });
+    colors->Modified();
+}
+
+void colorizeWeights(vtkPolyData* polyData, vtkIdType pointId, const std::function<double(vtkIdType)>& harmonic,
+                     const float* colorNeutral, const float* colorStart, const float* colorEnd) {
+    std::vector<float> weights(polyData->GetNumberOfPoints());
+    for (vtkIdType i = 0; i < static_cast<vtkIdType>(weights.size()); ++i) {
+        weights[i] = static_cast<float>(harmonic(i));
+    }
+    colorizeWeights(polyData, pointId, weights, colorNeutral, colorStart, colorEnd);
+}
@@ -1,72 +1,257 @@
 #include "deformations.hpp"
 
+#include <vtkCellArray.h>
 #include <vtkPointData.h>
-#include <vtkPolyDataNormals.h>
+#include <vtkPoints.h>
+#include <vtkWeakPointer.h>
 
-#include "harmonicFn.hpp"
+#include <Eigen/Core>
+#include <Eigen/Sparse>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
 
-void laplacianSmoothing(vtkPolyData* mesh, int numIterations) {
-    auto neighbors = buildNeighborMap(mesh);
+#include "HalfEdgeMesh.hpp"
+#include "MeshGeometry.hpp"
+#include "ScratchArena.hpp"
+#include "memoryUsage.hpp"
+#include "meshSharing.hpp"
 
-    auto smoothedMesh = vtkSmartPointer<vtkPolyData>::New();
-    smoothedMesh->DeepCopy(mesh);
-    auto points = smoothedMesh->GetPoints();
+PointRange laplacianSmoothing(vtkPolyData* mesh, int numIterations, const std::function<void(double)>& progress) {
+    MemoryScope scope("laplacianSmoothing");
+    detachSharedPoints(mesh);
+    auto topology = HalfEdgeMesh::get(mesh);
+
+    // the points are smoothed in place, every iteration reads a copy of the previous positions
+    auto points = mesh->GetPoints();
+    vtkSmartPointer<vtkPoints> previousPoints = vtkSmartPointer<vtkPoints>::New();
+    MemoryScope::observe(points->GetActualMemorySize() * 1024);
 
     for (int i = 0; i < numIterations; ++i) {
-        vtkSmartPointer<vtkPoints> newPoints = vtkSmartPointer<vtkPoints>::New();
-        newPoints->DeepCopy(points);
+        previousPoints->DeepCopy(points);
 
         for (vtkIdType ptId = 0; ptId < points->GetNumberOfPoints(); ++ptId) {
             double laplacian[3] = {0.0, 0.0, 0.0};
 
-            if (auto search = neighbors.find(ptId); search != neighbors.end()) {
-                long numNeighbors = search->second.size();
+            if (auto neighbors = topology->neighbors(ptId); !neighbors.empty()) {
+                long numNeighbors = neighbors.size();
                 double neighborPosition[3] = {0.0, 0.0, 0.0};
-                for (auto neighbor : search->second) {
-                    points->GetPoint(neighbor, neighborPosition);
+                for (auto neighbor : neighbors) {
+                    previousPoints->GetPoint(neighbor, neighborPosition);
                     for (int i = 0; i < 3; ++i) {
                         laplacian[i] += neighborPosition[i];
                     }
                 }
                 double currentPosition[3];
-                points->GetPoint(ptId, currentPosition);
+                previousPoints->GetPoint(ptId, currentPosition);
 
                 double newPosition[3];
                 for (int i = 0; i < 3; ++i) {
                     newPosition[i] = (currentPosition[i] + laplacian[i]) / (numNeighbors + 1);
                 }
-                newPoints->SetPoint(ptId, newPosition);
+                points->SetPoint(ptId, newPosition);
             }
         }
-        points->DeepCopy(newPoints);
+        if (progress) progress(static_cast<double>(i + 1) / numIterations);
     }
-    mesh->DeepCopy(smoothedMesh);
+    points->Modified();
+    return {0, numIterations > 0 ? points->GetNumberOfPoints() : 0};
 }
 
-void weightedTranslate(vtkPolyData* mesh, vtkIdType ptId, double dist, std::function<double(vtkIdType)> weightFn) {
-    auto normals = vtkSmartPointer<vtkPolyDataNormals>::New();
-    normals->SetInputData(mesh);
-    normals->ComputeCellNormalsOff();
-    normals->ComputePointNormalsOn();
-    normals->Update();
-    auto out = normals->GetOutput();
-    double* normal = out->GetPointData()->GetNormals()->GetTuple(ptId);
-    double max = weightFn(ptId);
+namespace {
+struct FairingOperator {
+    Eigen::SimplicialLDLT<Eigen::SparseMatrix<double>> solver;
+    Eigen::VectorXd mass;
+    std::size_t bytes = 0;
+};
+
+// the points and polygons are held weakly, an array freed and another allocated at its address is not mistaken for it
+struct FairingEntry {
+    vtkWeakPointer<vtkPolyData> mesh;
+    vtkWeakPointer<vtkPoints> points;
+    vtkWeakPointer<vtkCellArray> polys;
+    vtkMTimeType polysTime;
+    double stepSize;
+    FairingWeights weights;
+    bool biLaplacian;
+    std::shared_ptr<const FairingOperator> fairing;
+};
+std::mutex fairingMutex;
+std::unordered_map<vtkPolyData*, FairingEntry> fairingCache;
+
+std::shared_ptr<const FairingOperator> findFairingLocked(vtkPolyData* mesh, double stepSize, FairingWeights weights,
+                                                         bool biLaplacian) {
+    std::erase_if(fairingCache, [](const auto& entry) { return entry.second.mesh == nullptr; });
+    if (auto search = fairingCache.find(mesh); search != fairingCache.end()) {
+        auto& entry = search->second;
+        if (entry.points == mesh->GetPoints() && entry.polys == mesh->GetPolys() &&
+            entry.polysTime == mesh->GetPolys()->GetMTime() && entry.stepSize == stepSize &&
+            entry.weights == weights && entry.biLaplacian == biLaplacian) {
+            return entry.fairing;
+        }
+    }
+    return nullptr;
+}
+
+// M + s K, or M + s^2 K M^-1 K for the bi-Laplacian, symmetric positive definite
+std::shared_ptr<const FairingOperator> buildFairing(vtkPolyData* mesh, const HalfEdgeMesh& topology, double stepSize,
+                                                    FairingWeights weights, bool biLaplacian) {
+    using namespace Eigen;
+    const Index n = topology.numberOfVertices();
+    auto fairing = std::make_shared<FairingOperator>();
+    fairing->mass.resize(n);
+
+    std::pmr::vector<Triplet<double>> triplets(ScratchArena::resource());
+    double scale = stepSize;
+    if (weights == FairingWeights::Uniform) {
+        triplets.reserve(4 * topology.edges().size());
+        for (auto [a, b] : topology.edges()) {
+            triplets.emplace_back(a, b, -1.0);
+            triplets.emplace_back(b, a, -1.0);
+            triplets.emplace_back(a, a, 1.0);
+            triplets.emplace_back(b, b, 1.0);
+        }
+        for (Index i = 0; i < n; ++i) fairing->mass[i] = static_cast<double>(topology.neighbors(i).size());
+    } else {
+        auto geometry = MeshGeometry::get(mesh);
+        geometry->cotangentStiffness(triplets);
+        for (Index i = 0; i < n; ++i) fairing->mass[i] = geometry->vertexArea(i);
+        double h = geometry->meanEdgeLength(mesh->GetPoints());
+        scale *= h * h / 4.0;
+    }
+    // the points outside of the faces have no mass and no neighbor, they stay in place
+    for (Index i = 0; i < n; ++i) {
+        if (fairing->mass[i] <= 0.0) fairing->mass[i] = 1.0;
+    }
+    SparseMatrix<double> K(n, n);
+    K.setFromTriplets(triplets.begin(), triplets.end());
+    MemoryScope::observe(containerBytes(triplets) + K.nonZeros() * (sizeof(double) + sizeof(int)));
+    triplets = std::pmr::vector<Triplet<double>>(ScratchArena::resource());
 
-    auto newMesh = vtkSmartPointer<vtkPolyData>::New();
-    newMesh->DeepCopy(mesh);
+    SparseMatrix<double> A(n, n);
+    if (biLaplacian) {
+        SparseMatrix<double> scaledK = fairing->mass.cwiseInverse().asDiagonal() * K;
+        A = (scale * scale) * (K * scaledK);
+    } else {
+        A = scale * K;
+    }
+    SparseMatrix<double> M(n, n);
+    M.setIdentity();
+    M.diagonal() = fairing->mass;
+    A += M;
+    fairing->solver.compute(A);
+    if (fairing->solver.info() != Success) throw std::runtime_error("cannot factorize the fairing operator");
+    fairing->bytes = fairing->solver.matrixL().nestedExpression().nonZeros() * (sizeof(double) + sizeof(int)) +
+                     n * (2 * sizeof(double) + 2 * sizeof(int));
+    MemoryScope::observe(A.nonZeros() * (sizeof(double) + sizeof(int)) + fairing->bytes);
+    return fairing;
+}
 
-    for (vtkIdType p = 0; p < mesh->GetNumberOfPoints(); ++p) {
+std::size_t predictFairingOperatorBytes(vtkPolyData* mesh, bool biLaplacian) {
+    // the square of the stiffness matrix reaches the 2-rings
+    std::size_t nonZeros = (biLaplacian ? 3 : 1) * MeshGeometry::predictStiffnessNonZeros(mesh);
+    std::size_t matrixBytes = nonZeros * (sizeof(double) + sizeof(int));
+    return 2 * matrixBytes + MeshGeometry::ldltFillFactor * matrixBytes;
+}
+}  // namespace
+
+PointRange implicitFairing(vtkPolyData* mesh, double stepSize, FairingWeights weights, bool biLaplacian) {
+    using namespace Eigen;
+    MemoryScope scope("implicitFairing");
+    detachSharedPoints(mesh);
+    auto topology = HalfEdgeMesh::get(mesh);
+    const Index n = topology->numberOfVertices();
+    if (n == 0) return {};
+
+    std::shared_ptr<const FairingOperator> fairing;
+    {
+        std::lock_guard lock(fairingMutex);
+        fairing = findFairingLocked(mesh, stepSize, weights, biLaplacian);
+    }
+    if (fairing == nullptr) {
+        fairing = buildFairing(mesh, *topology, stepSize, weights, biLaplacian);
+        std::lock_guard lock(fairingMutex);
+        vtkCellArray* polys = mesh->GetPolys();
+        fairingCache[mesh] = {mesh, mesh->GetPoints(), polys, polys->GetMTime(), stepSize, weights, biLaplacian,
+                              fairing};
+    }
+
+    // the three coordinates are solved at once, the right hand side is M x
+    vtkPoints* points = mesh->GetPoints();
+    MatrixX3d x(n, 3);
+    for (Index i = 0; i < n; ++i) {
+        double position[3];
+        points->GetPoint(i, position);
+        x.row(i) = fairing->mass[i] * Map<const RowVector3d>(position);
+    }
+    MatrixX3d smoothed = fairing->solver.solve(x);
+    MemoryScope::observe(fairing->bytes + 2 * x.size() * sizeof(double));
+    for (Index i = 0; i < n; ++i) {
+        points->SetPoint(i, smoothed(i, 0), smoothed(i, 1), smoothed(i, 2));
+    }
+    points->Modified();
+    return {0, n};
+}
+
+std::vector<PointRange> weightedTranslate(vtkPolyData* mesh, vtkIdType ptId, double dist,
+                                          const std::function<double(vtkIdType)>& weightFn,
+                                          std::span<const vtkIdType> support) {
+    MemoryScope scope("weightedTranslate");
+    detachSharedPoints(mesh);
+    auto geometry = MeshGeometry::get(mesh);
+    Eigen::Vector3d normal = geometry->vertexNormal(ptId);
+    double max = weightFn(ptId);
+
+    // the points are moved in place, only the points with a weight are dirty for the cached geometry
+    vtkPoints* points = mesh->GetPoints();
+    std::pmr::vector<vtkIdType> moved(ScratchArena::resource());
+    std::vector<PointRange> ranges;
+    for (auto p : support) {
         double weight = weightFn(p);
+        if (weight == 0.0) continue;
         double normalized = weight / max;
-        double translation[3] = {dist * normalized * normal[0], dist * normalized * normal[1],
-                                 dist * normalized * normal[2]};
-        double* currentPosition = mesh->GetPoints()->GetPoint(p);
-        double newPosition[3];
+        double position[3];
+        points->GetPoint(p, position);
         for (int i = 0; i < 3; ++i) {
-            newPosition[i] = currentPosition[i] + translation[i];
+            position[i] += dist * normalized * normal[i];
+        }
+        points->SetPoint(p, position);
+        moved.push_back(p);
+        if (!ranges.empty() && ranges.back().end == p) {
+            ++ranges.back().end;
+        } else {
+            ranges.push_back({p, p + 1});
         }
-        newMesh->GetPoints()->SetPoint(p, newPosition);
     }
-    mesh->DeepCopy(newMesh);
-}
\ No newline at end of file
+    if (moved.empty()) return {};
+    MemoryScope::observe(containerBytes(moved) + containerBytes(ranges));
+    points->Modified();
+    MeshGeometry::update(mesh, moved);
+    return ranges;
+}
+
+std::size_t predictLaplacianSmoothingBytes(vtkPolyData* mesh) {
+    std::size_t bytes = HalfEdgeMesh::find(mesh) ? 0 : HalfEdgeMesh::predictBytes(mesh);
+    return bytes + static_cast<std::size_t>(mesh->GetPoints()->GetActualMemorySize()) * 1024;
+}
+
+std::size_t predictImplicitFairingBytes(vtkPolyData* mesh, double stepSize, FairingWeights weights, bool biLaplacian) {
+    std::size_t bytes = HalfEdgeMesh::find(mesh) ? 0 : HalfEdgeMesh::predictBytes(mesh);
+    if (weights == FairingWeights::Cotangent && !MeshGeometry::find(mesh)) bytes += MeshGeometry::predictBytes(mesh);
+    bytes += 6 * mesh->GetNumberOfPoints() * sizeof(double);
+    std::lock_guard lock(fairingMutex);
+    if (findFairingLocked(mesh, stepSize, weights, biLaplacian) == nullptr) {
+        bytes += predictFairingOperatorBytes(mesh, biLaplacian);
+    }
+    return bytes;
+}
+
+std::size_t implicitFairingCacheBytes(vtkPolyData* mesh) {
+    std::lock_guard lock(fairingMutex);
+    std::erase_if(fairingCache, [](const auto& entry) { return entry.second.mesh == nullptr; });
+    if (auto search = fairingCache.find(mesh); search != fairingCache.end()) return search->second.fairing->bytes;
+    return 0;
+}
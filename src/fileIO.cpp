@@ -1,11 +1,27 @@
 #include "fileIO.hpp"
 
-#include <vtkOBJReader.h>
+#include <vtkCellArray.h>
+#include <vtkCommand.h>
+#include <vtkIdTypeArray.h>
+#include <vtkOBJWriter.h>
 #include <vtkPLYReader.h>
-#include <vtkPolyDataMapper.h>
+#include <vtkPLYWriter.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+#include <vtkSmartPointer.h>
+#include <vtkTriangleFilter.h>
 
+#include <algorithm>
+#include <cstdint>
 #include <format>
 #include <iostream>
+#include <span>
+#include <stdexcept>
+
+#include "PartialUploadPolyDataMapper.hpp"
+#include "meshReorder.hpp"
+#include "meshSharing.hpp"
+#include "outOfCore.hpp"
 
 #include "nfd.h"
 #ifdef _WIN32
@@ -34,14 +50,126 @@ std::optional<std::filesystem::path> pickModelFile() {
     return std::nullopt;
 }
 
-template <typename Reader>
-void openFile(const std::filesystem::path &path, vtkRenderer *renderer) {
-    vtkNew<Reader> reader;
+std::optional<std::filesystem::path> pickSaveFile(const std::string &defaultName) {
+    nfdchar_t *outPath;
+    nfdfilteritem_t filterItem[2] = {{"Wavefront OBJ (.obj)", "obj"}, {"Polygon File Format (.ply)", "ply"}};
+    nfdresult_t result = NFD_SaveDialog(&outPath, filterItem, 2, NULL, defaultName.c_str());
+
+    if (result != NFD_OKAY && result != NFD_CANCEL) {
+        std::cerr << std::format("Error: {}\n", NFD_GetError());
+    }
+    if (result == NFD_OKAY) {
+        std::filesystem::path path{outPath};
+        NFD_FreePath(outPath);
+        return path;
+    }
+    return std::nullopt;
+}
+
+namespace {
+/**
+ * Forwards the progress events of a reader, and aborts the reader when a stop is requested.
+ */
+class ReaderObserver {
+   public:
+    ReaderObserver(const std::function<void(double)> &progress, std::stop_token stopToken)
+        : m_progress(progress), m_stopToken(std::move(stopToken)) {}
+
+    void onProgress(vtkObject *caller, unsigned long, void *callData) {
+        if (m_progress) m_progress(*static_cast<double *>(callData));
+        if (m_stopToken.stop_requested()) static_cast<vtkAlgorithm *>(caller)->SetAbortExecute(1);
+    }
+
+   private:
+    const std::function<void(double)> &m_progress;
+    std::stop_token m_stopToken;
+};
+
+/**
+ * Reads the positions and the polygons of an OBJ file with the line parser of the out-of-core operations, which
+ * reports the bytes parsed and stops within a block of lines, where vtkOBJReader only reports the start and the end.
+ */
+vtkSmartPointer<vtkPolyData> readObj(const std::filesystem::path &path, const std::function<void(double)> &progress,
+                                     std::stop_token stopToken) {
+    vtkNew<vtkPoints> points;
+    vtkNew<vtkIdTypeArray> offsets;
+    vtkNew<vtkIdTypeArray> connectivity;
+    offsets->InsertNextValue(0);
+    std::int64_t lowest = 0;
+    std::int64_t highest = -1;
+    bool complete = parseObj(
+        path, [&](const double *p) { points->InsertNextPoint(p); },
+        [&](std::span<const std::int64_t> face) {
+            for (auto index : face) {
+                lowest = std::min(lowest, index);
+                highest = std::max(highest, index);
+                connectivity->InsertNextValue(index);
+            }
+            offsets->InsertNextValue(connectivity->GetNumberOfValues());
+        },
+        progress, std::move(stopToken));
+    if (!complete) return nullptr;
+    if (lowest < 0 || highest >= points->GetNumberOfPoints()) {
+        throw std::runtime_error(std::format("{} has faces using points it does not have", path.string()));
+    }
+    vtkNew<vtkCellArray> polys;
+    polys->SetData(offsets, connectivity);
+    auto mesh = vtkSmartPointer<vtkPolyData>::New();
+    mesh->SetPoints(points);
+    mesh->SetPolys(polys);
+    return mesh;
+}
+
+vtkSmartPointer<vtkPolyData> readPly(const std::filesystem::path &path, const std::function<void(double)> &progress,
+                                     std::stop_token stopToken) {
+    vtkNew<vtkPLYReader> reader;
+    ReaderObserver observer(progress, stopToken);
     reader->SetFileName(path.c_str());
+    reader->AddObserver(vtkCommand::ProgressEvent, &observer, &ReaderObserver::onProgress);
     reader->Update();
+    // the output of an aborted reader is incomplete
+    if (stopToken.stop_requested()) return nullptr;
+    return reader->GetOutput();
+}
+
+}  // namespace
+
+vtkSmartPointer<vtkPolyData> readMesh(const std::filesystem::path &path, bool reorder,
+                                      const std::function<void(double)> &progress, std::stop_token stopToken) {
+    if (path.extension() != ".obj" && path.extension() != ".ply") return nullptr;
+    vtkSmartPointer<vtkPolyData> mesh =
+        path.extension() == ".obj" ? readObj(path, progress, stopToken) : readPly(path, progress, stopToken);
+    if (mesh == nullptr || stopToken.stop_requested()) return nullptr;
+    // the kernels have fast paths for pure triangle and quad meshes, meshes mixing cell sizes are triangulated
+    if (mesh->GetPolys()->IsHomogeneous() < 0) {
+        vtkNew<vtkTriangleFilter> triangleFilter;
+        triangleFilter->SetInputData(mesh);
+        triangleFilter->Update();
+        mesh = triangleFilter->GetOutput();
+    }
+    if (stopToken.stop_requested()) return nullptr;
+    if (reorder) {
+        mesh = reorderForLocality(mesh);
+    }
+    return mesh;
+}
+
+vtkSmartPointer<vtkPolyData> loadMesh(const std::filesystem::path &path, bool reorder,
+                                      const std::function<void(double)> &progress, std::stop_token stopToken) {
+    if (path.extension() != ".obj" && path.extension() != ".ply") return nullptr;
+    // a file already opened shares the arrays of its first mesh instead of being read again
+    auto key = meshKey(path, reorder);
+    if (auto shared = findSharedMesh(key)) {
+        if (progress) progress(1.0);
+        return shared;
+    }
+    auto mesh = readMesh(path, reorder, progress, std::move(stopToken));
+    return mesh ? shareMesh(key, mesh) : nullptr;
+}
 
-    vtkNew<vtkPolyDataMapper> meshMapper;
-    meshMapper->SetInputConnection(reader->GetOutputPort());
+void addMeshActor(const std::filesystem::path &path, vtkPolyData *mesh, vtkRenderer *renderer) {
+    vtkNew<PartialUploadPolyDataMapper> meshMapper;
+    meshMapper->SetInputData(mesh);
 
     vtkNew<vtkActor> meshActor;
     meshActor->SetMapper(meshMapper);
@@ -51,10 +179,29 @@ void openFile(const std::filesystem::path &path, vtkRenderer *renderer) {
     renderer->AddActor(meshActor);
 }
 
-void openObjectFile(const std::filesystem::path &path, vtkRenderer *renderer) {
-    return openFile<vtkOBJReader>(path, renderer);
+void openObjectFile(const std::filesystem::path &path, vtkRenderer *renderer, bool reorder) {
+    return addMeshActor(path, loadMesh(path, reorder), renderer);
 };
 
-void openPLYFile(const std::filesystem::path &path, vtkRenderer *renderer) {
-    return openFile<vtkPLYReader>(path, renderer);
+void openPLYFile(const std::filesystem::path &path, vtkRenderer *renderer, bool reorder) {
+    return addMeshActor(path, loadMesh(path, reorder), renderer);
 };
+
+void saveMesh(const std::filesystem::path &path, vtkPolyData *mesh) {
+    // the file keeps the ids of the file the mesh was loaded from
+    auto original = restoreOriginalOrder(mesh);
+    if (path.extension() == ".obj") {
+        vtkNew<vtkOBJWriter> writer;
+        writer->SetFileName(path.string().c_str());
+        writer->SetInputData(original);
+        if (writer->Write() == 0) throw std::runtime_error(std::format("cannot write {}", path.string()));
+    } else if (path.extension() == ".ply") {
+        vtkNew<vtkPLYWriter> writer;
+        writer->SetFileName(path.string().c_str());
+        writer->SetInputData(original);
+        writer->SetArrayName("Colors");
+        if (writer->Write() == 0) throw std::runtime_error(std::format("cannot write {}", path.string()));
+    } else {
+        throw std::runtime_error(std::format("unknown file type {}", path.string()));
+    }
+}
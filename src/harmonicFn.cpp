@@ -4,119 +4,186 @@
 #include <Eigen/src/Core/util/Constants.h>
 #include <Eigen/src/SparseCore/SparseMatrix.h>
 #include <vtkCellArray.h>
-#include <vtkCellArrayIterator.h>
-#include <vtkIdList.h>
 #include <vtkPolyData.h>
-#include <vtkSmartPointer.h>
+#include <vtkSMPTools.h>
 #include <vtkType.h>
 
 #include <algorithm>
-#include <array>
 #include <iostream>
+#include <numeric>
+#include <ranges>
+#include <span>
 #include <utility>
+#include <vector>
 
-std::unordered_map<vtkIdType, long> buildRingMap(vtkPolyData* mesh, vtkIdType initPtId, long ringCount) {
-    std::unordered_map<vtkIdType, long> ringMap;
-    auto currentRing = vtkSmartPointer<vtkIdList>::New();
-    auto nextRing = vtkSmartPointer<vtkIdList>::New();
-    vtkSmartPointer<vtkIdList> temp;
-
-    vtkCellArray* polys = mesh->GetPolys();
-
-    currentRing->InsertNextId(initPtId);
-
-    for (int i = 0; i < ringCount; ++i) {
-        for (vtkIdType j = 0; j < currentRing->GetNumberOfIds(); ++j) {
-            auto pointId = currentRing->GetId(j);
-            if (!ringMap.contains(pointId)) {
-                ringMap[pointId] = i;
-
-                auto it = vtk::TakeSmartPointer(polys->NewIterator());
-                for (it->GoToFirstCell(); !it->IsDoneWithTraversal(); it->GoToNextCell()) {
-                    auto cell = it->GetCurrentCell();
-                    bool containsPoint = false;
-                    for (vtkIdType pt = 0; pt < cell->GetNumberOfIds(); ++pt) {
-                        containsPoint = containsPoint || (pointId == cell->GetId(pt));
-                    }
-                    if (containsPoint) {
-                        for (vtkIdType pt = 0; pt < cell->GetNumberOfIds(); ++pt) {
-                            auto ptId = cell->GetId(pt);
-                            if (pointId != ptId) nextRing->InsertUniqueId(ptId);
-                        }
-                    }
-                }
-            }
+#include "HalfEdgeMesh.hpp"
+#include "MeshGeometry.hpp"
+#include "PointGrid.hpp"
+#include "ScratchArena.hpp"
+#include "SpectralBasis.hpp"
+#include "memoryUsage.hpp"
+
+namespace {
+std::size_t sparseBytes(const Eigen::SparseMatrix<double>& m) {
+    return m.data().allocatedSize() * (sizeof(double) + sizeof(int)) + (m.outerSize() + 1) * 2 * sizeof(int);
+}
+
+std::size_t topologyBytes(vtkPolyData* mesh) {
+    return HalfEdgeMesh::find(mesh) ? 0 : HalfEdgeMesh::predictBytes(mesh);
+}
+
+std::size_t geometryBytes(vtkPolyData* mesh) {
+    return MeshGeometry::find(mesh) ? 0 : MeshGeometry::predictBytes(mesh);
+}
+
+template <typename K, typename V>
+std::size_t predictHashMapBytes(std::size_t size) {
+    return size * (sizeof(std::pair<const K, V>) + 3 * sizeof(void*));
+}
+
+// Eigen's SparseLU reserves fillfactor (20) times the nonzeros of the matrix for its factors
+constexpr std::size_t luFillFactor = 20;
+}  // namespace
+
+namespace {
+template <int Arity>
+std::pmr::unordered_map<vtkIdType, long> ringMapOf(const HalfEdgeMesh& topology, vtkIdType initPtId, long ringCount) {
+    std::pmr::unordered_map<vtkIdType, long> ringMap(ScratchArena::resource());
+    std::pmr::vector<vtkIdType> currentRing({initPtId}, ScratchArena::resource());
+    std::pmr::vector<vtkIdType> nextRing(ScratchArena::resource());
+    ringMap[initPtId] = 0;
+
+    for (long i = 1; i < ringCount && !currentRing.empty(); ++i) {
+        for (auto pointId : currentRing) {
+            topology.forEachFaceNeighbor<Arity>(pointId, [&](vtkIdType ptId) {
+                if (ringMap.try_emplace(ptId, i).second) nextRing.push_back(ptId);
+            });
         }
-        currentRing->Reset();
-        temp = currentRing;
-        currentRing = nextRing;
-        nextRing = temp;
+        currentRing.swap(nextRing);
+        nextRing.clear();
     }
     return ringMap;
 }
 
-std::unordered_map<vtkIdType, std::unordered_set<vtkIdType>> buildNeighborMap(vtkPolyData* mesh) {
-    std::unordered_map<vtkIdType, std::unordered_set<vtkIdType>> neighborMap;
-    vtkCellArray* polys = mesh->GetPolys();
-
-    auto it = vtk::TakeSmartPointer(polys->NewIterator());
-    for (it->GoToFirstCell(); !it->IsDoneWithTraversal(); it->GoToNextCell()) {
-        auto cell = it->GetCurrentCell();
-        for (vtkIdType i = 0; i < cell->GetNumberOfIds(); ++i) {
-            auto ptId = cell->GetId(i);
-
-            for (vtkIdType j = 0; j < cell->GetNumberOfIds(); ++j) {
-                if (i != j) {
-                    if (auto search = neighborMap.find(ptId); search != neighborMap.end()) {
-                        search->second.insert(cell->GetId(j));
-                    } else {
-                        neighborMap[ptId] = {cell->GetId(j)};
-                    }
-                }
+template <int Arity, typename Points>
+void appendRingFacesOf(const HalfEdgeMesh& topology, const Points& points,
+                       const std::pmr::unordered_map<vtkIdType, long>& ringMap, std::pmr::vector<vtkIdType>& faces) {
+    for (auto ptId : points) {
+        for (auto h : topology.outgoing(ptId)) {
+            // each face is reported once, from the vertex of its first corner
+            if (!topology.isFirstCorner<Arity>(h)) continue;
+            auto face = topology.faceOf<Arity>(h);
+            auto vertices = topology.faceVertices(face);
+            if (std::ranges::all_of(vertices, [&](vtkIdType v) { return ringMap.contains(v); })) {
+                faces.push_back(face);
             }
         }
     }
-    return neighborMap;
 }
+}  // namespace
 
-vtkSmartPointer<vtkCellArray> getRingTriangles(vtkPolyData* mesh, const std::unordered_map<vtkIdType, long>& ringMap) {
-    vtkCellArray* polys = mesh->GetPolys();
-    auto triangles = vtkSmartPointer<vtkCellArray>::New();
+std::pmr::unordered_map<vtkIdType, long> buildRingMap(vtkPolyData* mesh, vtkIdType initPtId, long ringCount) {
+    if (ringCount < 1) return std::pmr::unordered_map<vtkIdType, long>(ScratchArena::resource());
+    auto topology = HalfEdgeMesh::get(mesh);
+    return topology->dispatchArity(
+        [&](auto arity) { return ringMapOf<decltype(arity)::value>(*topology, initPtId, ringCount); });
+}
 
-    auto it = vtk::TakeSmartPointer(polys->NewIterator());
-    for (it->GoToFirstCell(); !it->IsDoneWithTraversal(); it->GoToNextCell()) {
-        auto cell = it->GetCurrentCell();
-        auto withinRing = true;
-        for (vtkIdType i = 0; i < cell->GetNumberOfIds(); ++i) {
-            auto ptId = cell->GetId(i);
-            withinRing = withinRing && ringMap.contains(ptId);
-        }
-        if (withinRing) {
-            triangles->InsertNextCell(cell);
-        }
-    }
-    return triangles;
+std::pmr::vector<vtkIdType> getRingTriangles(const HalfEdgeMesh& topology,
+                                             const std::pmr::unordered_map<vtkIdType, long>& ringMap) {
+    std::pmr::vector<vtkIdType> faces(ScratchArena::resource());
+    topology.dispatchArity([&](auto arity) {
+        appendRingFacesOf<decltype(arity)::value>(topology, std::views::keys(ringMap), ringMap, faces);
+    });
+    return faces;
 }
 
-std::function<double(vtkIdType)> simpleHarmonic(vtkPolyData* mesh, vtkIdType pointId, long ringCount) {
+void appendRingFaces(const HalfEdgeMesh& topology, std::span<const vtkIdType> points,
+                     const std::pmr::unordered_map<vtkIdType, long>& ringMap, std::pmr::vector<vtkIdType>& faces) {
+    topology.dispatchArity(
+        [&](auto arity) { appendRingFacesOf<decltype(arity)::value>(topology, points, ringMap, faces); });
+}
+
+namespace {
+/**
+ * The weights of each method are handed to a publisher while the temporaries of the method are alive: the weight
+ * function keeps a copy of them, allocated from the default resource out of the arena, and weightingValues scatters
+ * them into a dense buffer.
+ */
+constexpr auto asFunction = [](const auto& weights) -> std::function<double(vtkIdType)> { return weights; };
+
+struct RingWeights {
+    std::pmr::unordered_map<vtkIdType, long> rings;
+    long ringCount;
+
+    double weightOf(long ring) const { return static_cast<double>(ringCount - ring) / static_cast<double>(ringCount); }
+    double operator()(vtkIdType ptId) const {
+        auto search = rings.find(ptId);
+        return search != rings.end() ? weightOf(search->second) : 0.0;
+    }
+    void scatter(std::span<float> values) const {
+        for (const auto& [ptId, ring] : rings) values[ptId] = static_cast<float>(weightOf(ring));
+    }
+};
+
+struct SparseWeights {
+    std::pmr::unordered_map<vtkIdType, double> values;
+
+    double operator()(vtkIdType ptId) const {
+        auto search = values.find(ptId);
+        return search != values.end() ? search->second : 0.0;
+    }
+    void scatter(std::span<float> dense) const {
+        for (const auto& [ptId, value] : values) dense[ptId] = static_cast<float>(value);
+    }
+};
+
+struct SolutionWeights {
+    std::pmr::map<vtkIdType, long> rows;
+    Eigen::VectorXd solution;
+
+    double operator()(vtkIdType ptId) const {
+        auto search = rows.find(ptId);
+        return search != rows.end() ? std::abs(solution[search->second]) : 0.0;
+    }
+    void scatter(std::span<float> values) const {
+        for (const auto& [ptId, row] : rows) values[ptId] = static_cast<float>(std::abs(solution[row]));
+    }
+};
+
+struct RegionWeights {
+    std::vector<std::pair<vtkIdType, double>> region;  // sorted by id, a weight is a binary search
+
+    double operator()(vtkIdType ptId) const {
+        auto search = std::lower_bound(region.begin(), region.end(), ptId,
+                                       [](const auto& entry, vtkIdType id) { return entry.first < id; });
+        return search != region.end() && search->first == ptId ? search->second : 0.0;
+    }
+    void scatter(std::span<float> values) const {
+        for (const auto& [ptId, value] : region) values[ptId] = static_cast<float>(value);
+    }
+};
+
+template <typename Publish>
+auto simpleHarmonicWeights(vtkPolyData* mesh, vtkIdType pointId, long ringCount, Publish&& publish) {
+    MemoryScope scope("simpleHarmonic");
     auto ringMap = buildRingMap(mesh, pointId, ringCount);
-    return [=](vtkIdType ptId) {
-        if (auto search = ringMap.find(ptId); search != ringMap.end()) {
-            return static_cast<double>(ringCount - search->second) / static_cast<double>(ringCount);
-        } else {
-            return 0.0;
-        }
-    };
+    MemoryScope::observe(containerBytes(ringMap));
+    return publish(RingWeights{std::move(ringMap), ringCount});
 }
 
-std::function<double(vtkIdType)> laplacianDiffusion(vtkPolyData* mesh, vtkIdType ptId, double alpha, int iterations) {
-    auto neighborMap = buildNeighborMap(mesh);
-    std::unordered_map<vtkIdType, double> f;  // currentValue
-    std::unordered_map<vtkIdType, double> g;  // newValue
+template <typename Publish>
+auto laplacianDiffusionWeights(vtkPolyData* mesh, vtkIdType ptId, double alpha, int iterations,
+                               const std::function<void(double)>& progress, Publish&& publish) {
+    MemoryScope scope("laplacianDiffusion");
+    auto topology = HalfEdgeMesh::get(mesh);
+    std::pmr::unordered_map<vtkIdType, double> f(ScratchArena::resource());  // currentValue
+    std::pmr::unordered_map<vtkIdType, double> g(ScratchArena::resource());  // newValue
     f[ptId] = 1.0;
     for (int i = 0; i < iterations; ++i) {
         for (vtkIdType ptId = 0; ptId < mesh->GetNumberOfPoints(); ++ptId) {
-            auto neighbors = neighborMap[ptId];
+            auto neighbors = topology->neighbors(ptId);
+            if (neighbors.empty()) continue;
             double weight = 0.0;
             double weightOfNeighbors = 0.0;
             if (auto search = f.find(ptId); search != f.end()) {
@@ -131,77 +198,83 @@ std::function<double(vtkIdType)> laplacianDiffusion(vtkPolyData* mesh, vtkIdType
                 g[ptId] = (1.0 - alpha) * weight + alpha * (1.0 / neighbors.size()) * weightOfNeighbors;
             }
         }
-        f = g;
+        // the support only grows, every value of the previous iteration is overwritten by the next one
+        std::swap(f, g);
+        MemoryScope::observe(containerBytes(f) + containerBytes(g));
+        if (progress) progress(static_cast<double>(i + 1) / iterations);
     }
-    return [=](vtkIdType ptId) {
-        if (auto search = f.find(ptId); search != f.end()) {
-            return search->second;
-        } else {
-            return 0.0;
+    return publish(SparseWeights{std::move(f)});
+}
+}  // namespace
+
+void addRingTriplets(vtkPolyData* mesh, std::span<const vtkIdType> faces,
+                     const std::pmr::map<vtkIdType, long>& pointMap, long lastRingStart,
+                     std::pmr::vector<Eigen::Triplet<double>>& triplets) {
+    auto addEdge = [&](vtkIdType I, vtkIdType J, double cotan) {
+        long i = pointMap.find(I)->second;
+        long j = pointMap.find(J)->second;
+
+        double halfCotan = 0.5 * cotan;
+        if (i < lastRingStart) {
+            triplets.emplace_back(i, j, halfCotan);
+            triplets.emplace_back(i, i, -halfCotan);
+        }
+        if (j < lastRingStart) {
+            triplets.emplace_back(j, j, -halfCotan);
+            triplets.emplace_back(j, i, halfCotan);
         }
     };
+    // cotangents are only defined on triangles, quads and polygons contribute the triangles of their fan
+    // the cotangents are read from the cached geometry, kept up to date by the deformations
+    auto topology = HalfEdgeMesh::get(mesh);
+    auto geometry = MeshGeometry::get(mesh);
+    topology->dispatchArity([&](auto arity) {
+        for (auto face : faces) {
+            auto t = geometry->firstTriangle(face);
+            topology->forEachTriangle<decltype(arity)::value>(face, [&](vtkIdType a, vtkIdType b, vtkIdType c) {
+                // the edge opposite to each corner
+                addEdge(b, c, geometry->cotangent(t, 0));
+                addEdge(c, a, geometry->cotangent(t, 1));
+                addEdge(a, b, geometry->cotangent(t, 2));
+                ++t;
+            });
+        }
+    });
 }
 
 Eigen::SparseMatrix<double> laplacianMatrix(vtkPolyData* mesh, vtkIdType ptId,
-                                            const std::map<vtkIdType, long>& pointMap,
-                                            const std::unordered_map<vtkIdType, long>& ringMap, long lastRingStart) {
+                                            const std::pmr::map<vtkIdType, long>& pointMap,
+                                            const std::pmr::unordered_map<vtkIdType, long>& ringMap,
+                                            long lastRingStart) {
     using namespace Eigen;
 
-    auto triangles = getRingTriangles(mesh, ringMap);
+    auto topology = HalfEdgeMesh::get(mesh);
+    auto triangles = getRingTriangles(*topology, ringMap);
     auto nbPoints = ringMap.size();
 
-    SparseMatrix<double> L(nbPoints, nbPoints);
-    L.setZero();
-
-    auto it = vtk::TakeSmartPointer(triangles->NewIterator());
-    for (it->GoToFirstCell(); !it->IsDoneWithTraversal(); it->GoToNextCell()) {
-        auto triangle = it->GetCurrentCell();
-        struct Edge {
-            vtkIdType i, j, orig;
-        };
-        const std::array<Edge, 3> edges = {{{0, 1, 2}, {0, 2, 1}, {1, 2, 0}}};
-        for (const auto& edge : edges) {
-            vtkIdType I = triangle->GetId(edge.i);
-            vtkIdType J = triangle->GetId(edge.j);
-            vtkIdType Orig = triangle->GetId(edge.orig);
-
-            long i = pointMap.find(I)->second;
-            long j = pointMap.find(J)->second;
-
-            Vector3d pi = Map<Vector3d>(mesh->GetPoint(I));
-            Vector3d pj = Map<Vector3d>(mesh->GetPoint(J));
-            Vector3d porig = Map<Vector3d>(mesh->GetPoint(Orig));
-
-            Vector3d v1 = porig - pi;
-            Vector3d v2 = porig - pj;
-
-            double halfCotan = 0.5 * (v1.dot(v2)) / ((v1.cross(v2)).norm());
-            if (i < lastRingStart) {
-                L.coeffRef(i, j) += halfCotan;
-                L.coeffRef(i, i) -= halfCotan;
-            }
-            if (j < lastRingStart) {
-                L.coeffRef(j, j) -= halfCotan;
-                L.coeffRef(j, i) += halfCotan;
-            }
-        }
-    }
+    // the entries are collected in the arena and summed by setFromTriplets, instead of growing the matrix in place
+    std::pmr::vector<Triplet<double>> triplets(ScratchArena::resource());
+    triplets.reserve(12 * triangles.size() + nbPoints);
+    addRingTriplets(mesh, triangles, pointMap, lastRingStart, triplets);
 
+    // the rows of the last ring have no other entries
     for (long i = lastRingStart; i < nbPoints; ++i) {
-        L.coeffRef(i, i) = 1;
+        triplets.emplace_back(i, i, 1.0);
     }
+    MemoryScope::observe(containerBytes(ringMap) + containerBytes(pointMap) + containerBytes(triangles) +
+                         containerBytes(triplets));
+    SparseMatrix<double> L(nbPoints, nbPoints);
+    L.setFromTriplets(triplets.begin(), triplets.end());
     return L;
 }
 
-std::function<double(vtkIdType)> solveLaplace(vtkPolyData* mesh, vtkIdType ptId, int ringCount) {
-    using namespace Eigen;
-    auto ringMap = buildRingMap(mesh, ptId, ringCount);
-    auto nbPoints = ringMap.size();
+std::pair<std::pmr::map<vtkIdType, long>, long> ringRows(const std::pmr::unordered_map<vtkIdType, long>& ringMap,
+                                                         int ringCount) {
     // keep track of the ordering since I did not until now...
     // and also keep track of the borders
-    std::map<vtkIdType, long> pointMap;
+    std::pmr::map<vtkIdType, long> pointMap(ScratchArena::resource());
     long pos = 0;
-    long lastRingStart = nbPoints;
+    long lastRingStart = ringMap.size();
     for (long i = 0; i < ringCount; ++i) {
         for (auto pt_ring : ringMap) {
             vtkIdType ptid = pt_ring.first;
@@ -215,10 +288,26 @@ std::function<double(vtkIdType)> solveLaplace(vtkPolyData* mesh, vtkIdType ptId,
             }
         }
     }
-    auto L = laplacianMatrix(mesh, ptId, pointMap, ringMap, lastRingStart);
+    return {std::move(pointMap), lastRingStart};
+}
+
+namespace {
+template <typename Publish>
+auto solveLaplaceWeights(vtkPolyData* mesh, vtkIdType ptId, int ringCount, Publish&& publish) {
+    using namespace Eigen;
+    MemoryScope scope("solveLaplace");
+    auto ringMap = buildRingMap(mesh, ptId, ringCount);
+    auto nbPoints = ringMap.size();
+    auto rows = ringRows(ringMap, ringCount);
+    const auto& pointMap = rows.first;
+    auto L = laplacianMatrix(mesh, ptId, pointMap, ringMap, rows.second);
+    std::size_t mapsBytes = containerBytes(ringMap) + containerBytes(pointMap);
+    MemoryScope::observe(mapsBytes + sparseBytes(L));
 
     SparseLU<SparseMatrix<double>> solver;
     solver.compute(L);
+    MemoryScope::observe(mapsBytes + sparseBytes(L) + (solver.nnzL() + solver.nnzU()) * (sizeof(double) + sizeof(int)) +
+                         2 * nbPoints * sizeof(double));
 
     VectorXd rhs = VectorXd::Constant(nbPoints, 0.0);
     rhs(0) = 1.0;
@@ -229,11 +318,161 @@ std::function<double(vtkIdType)> solveLaplace(vtkPolyData* mesh, vtkIdType ptId,
         std::cerr << "Solving failed!" << std::endl;
     }
 
-    return [=](vtkIdType ptId) {
-        if (auto search = pointMap.find(ptId); search != pointMap.end()) {
-            return std::abs(res[search->second]);
-        } else {
-            return 0.0;
+    return publish(SolutionWeights{std::move(rows.first), std::move(res)});
+}
+
+template <typename Publish>
+auto radiusFalloffWeights(vtkPolyData* mesh, vtkIdType ptId, double radius, Publish&& publish) {
+    MemoryScope scope("radiusFalloff");
+    auto grid = PointGrid::get(mesh);
+    double center[3];
+    mesh->GetPoint(ptId, center);
+
+    std::vector<std::pair<vtkIdType, double>> region;
+    grid->forEachInRadius(center, radius, [&](vtkIdType id, double squaredDistance) {
+        region.emplace_back(id, squaredDistance);
+    });
+    const double squaredRadius = radius * radius;
+    vtkSMPTools::For(0, static_cast<vtkIdType>(region.size()), [&](vtkIdType begin, vtkIdType end) {
+        for (vtkIdType i = begin; i < end; ++i) {
+            double t = squaredRadius > 0.0 ? 1.0 - region[i].second / squaredRadius : 1.0;
+            region[i].second = t * t;
         }
-    };
-}
\ No newline at end of file
+    });
+    vtkSMPTools::Sort(region.begin(), region.end());
+    MemoryScope::observe(containerBytes(region));
+
+    return publish(RegionWeights{std::move(region)});
+}
+}  // namespace
+
+std::function<double(vtkIdType)> simpleHarmonic(vtkPolyData* mesh, vtkIdType pointId, long ringCount) {
+    return simpleHarmonicWeights(mesh, pointId, ringCount, asFunction);
+}
+
+std::function<double(vtkIdType)> laplacianDiffusion(vtkPolyData* mesh, vtkIdType ptId, double alpha, int iterations,
+                                                    const std::function<void(double)>& progress) {
+    return laplacianDiffusionWeights(mesh, ptId, alpha, iterations, progress, asFunction);
+}
+
+std::function<double(vtkIdType)> solveLaplace(vtkPolyData* mesh, vtkIdType ptId, int ringCount) {
+    return solveLaplaceWeights(mesh, ptId, ringCount, asFunction);
+}
+
+std::function<double(vtkIdType)> radiusFalloff(vtkPolyData* mesh, vtkIdType ptId, double radius) {
+    return radiusFalloffWeights(mesh, ptId, radius, asFunction);
+}
+
+std::function<double(vtkIdType)> weightingFunction(int method, vtkPolyData* mesh, vtkIdType ptId, int ringCount,
+                                                   double alpha, int nbModes, double radius) {
+    if (method == 0) {
+        return simpleHarmonic(mesh, ptId, ringCount);
+    } else if (method == 1) {
+        return laplacianDiffusion(mesh, ptId, alpha, ringCount);
+    } else if (method == 2) {
+        return solveLaplace(mesh, ptId, ringCount);
+    } else if (method == 3) {
+        return spectralDiffusion(mesh, ptId, alpha, ringCount, nbModes);
+    } else {
+        return radiusFalloff(mesh, ptId, radius);
+    }
+}
+
+std::vector<float> weightingValues(int method, vtkPolyData* mesh, vtkIdType ptId, int ringCount, double alpha,
+                                   int nbModes, double radius, const std::function<void(double)>& progress) {
+    std::vector<float> values(mesh->GetNumberOfPoints(), 0.0f);
+    auto scatter = [&](const auto& weights) { weights.scatter(values); };
+    if (method == 0) {
+        simpleHarmonicWeights(mesh, ptId, ringCount, scatter);
+    } else if (method == 1) {
+        laplacianDiffusionWeights(mesh, ptId, alpha, ringCount, progress, scatter);
+    } else if (method == 2) {
+        solveLaplaceWeights(mesh, ptId, ringCount, scatter);
+    } else if (method == 3) {
+        spectralDiffusion(mesh, ptId, alpha, ringCount, nbModes, values);
+    } else {
+        radiusFalloffWeights(mesh, ptId, radius, scatter);
+    }
+    return values;
+}
+
+std::pmr::vector<vtkIdType> weightingSupport(int method, vtkPolyData* mesh, vtkIdType ptId, int ringCount,
+                                             double radius) {
+    std::pmr::vector<vtkIdType> support(ScratchArena::resource());
+    if (method == 3) {
+        support.resize(mesh->GetNumberOfPoints());
+        std::iota(support.begin(), support.end(), vtkIdType{0});
+        return support;
+    }
+    if (method == 4) {
+        double center[3];
+        mesh->GetPoint(ptId, center);
+        PointGrid::get(mesh)->forEachInRadius(center, radius, [&](vtkIdType id, double) { support.push_back(id); });
+    } else {
+        for (const auto& [id, ring] : buildRingMap(mesh, ptId, method == 1 ? ringCount + 1 : ringCount)) {
+            support.push_back(id);
+        }
+    }
+    std::sort(support.begin(), support.end());
+    return support;
+}
+
+namespace {
+/**
+ * Estimates the number of points within ringCount rings of a point without walking the rings: the k-th ring of a
+ * regular mesh has about k times the mean valence points.
+ *
+ * @return the number of points, and the mean valence.
+ */
+std::pair<std::size_t, double> predictRingPoints(vtkPolyData* mesh, long ringCount) {
+    const auto nbPoints = mesh->GetNumberOfPoints();
+    if (ringCount < 1 || nbPoints == 0) return {0, 0.0};
+    // every corner of a face starts a half-edge, and a point of a closed mesh starts as many as it has neighbors
+    auto topology = HalfEdgeMesh::find(mesh);
+    const double halfEdges = topology ? topology->numberOfHalfEdges() : mesh->GetPolys()->GetNumberOfConnectivityIds();
+    const double valence = halfEdges / static_cast<double>(nbPoints);
+    const double rings = static_cast<double>(ringCount - 1);
+    const double points = 1.0 + valence * rings * (rings + 1.0) / 2.0;
+    return {static_cast<std::size_t>(std::min(points, static_cast<double>(nbPoints))), valence};
+}
+}  // namespace
+
+std::size_t predictSimpleHarmonicBytes(vtkPolyData* mesh, long ringCount) {
+    auto nbPoints = predictRingPoints(mesh, ringCount).first;
+    return topologyBytes(mesh) + predictHashMapBytes<vtkIdType, long>(nbPoints);
+}
+
+std::size_t predictLaplacianDiffusionBytes(vtkPolyData* mesh) {
+    // the current and new values may cover every point, and the arena keeps the buckets left by their rehashes
+    return topologyBytes(mesh) + 3 * predictHashMapBytes<vtkIdType, double>(mesh->GetNumberOfPoints());
+}
+
+std::size_t predictSolveLaplaceBytes(vtkPolyData* mesh, int ringCount) {
+    auto [nbPoints, valence] = predictRingPoints(mesh, ringCount);
+    // a row has a nonzero per neighbor and the diagonal
+    auto nonZeros = static_cast<std::size_t>((valence + 1.0) * static_cast<double>(nbPoints));
+    std::size_t entryBytes = sizeof(double) + sizeof(int);
+    std::size_t bytes = topologyBytes(mesh) + geometryBytes(mesh);
+    bytes += predictHashMapBytes<vtkIdType, long>(nbPoints);                            // ring map
+    bytes += nbPoints * (sizeof(std::pair<const vtkIdType, long>) + 4 * sizeof(void*));  // point map
+    bytes += 2 * nbPoints * sizeof(vtkIdType);                                          // ring triangles
+    bytes += 24 * nbPoints * sizeof(Eigen::Triplet<double>);  // triplets, two triangles per point
+    bytes += nonZeros * entryBytes;                           // matrix
+    bytes += luFillFactor * nonZeros * entryBytes;            // LU factors
+    bytes += 2 * nbPoints * sizeof(double);                   // right hand side and solution
+    return bytes;
+}
+
+std::size_t predictSpectralDiffusionBytes(vtkPolyData* mesh, int nbModes) {
+    auto basis = SpectralBasis::find(mesh);
+    if (basis != nullptr && basis->requestedModes() >= std::min<vtkIdType>(nbModes, mesh->GetNumberOfPoints())) {
+        return 0;
+    }
+    return topologyBytes(mesh) + geometryBytes(mesh) + SpectralBasis::predictBytes(mesh, nbModes);
+}
+
+std::size_t predictRadiusFalloffBytes(vtkPolyData* mesh) {
+    // the region may cover every point, and its vector may be twice its size
+    std::size_t bytes = PointGrid::find(mesh) ? 0 : PointGrid::predictBytes(mesh);
+    return bytes + 2 * mesh->GetNumberOfPoints() * sizeof(std::pair<vtkIdType, double>);
+}
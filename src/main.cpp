@@ -1,12 +1,54 @@
 #include <SDL.h>
 #include <SDL_hints.h>
 
+#include <exception>
+#include <format>
+#include <iostream>
+#include <string>
+#include <string_view>
+
 #include "Application.hpp"
-int main() {
+#include "outOfCore.hpp"
+#include "sessionReplay.hpp"
+
+namespace {
+/**
+ * geo --smooth-out-of-core <input.obj|raw> <output.obj|raw> <iterations> [chunk points], without opening a window.
+ */
+int smoothOutOfCore(int argc, char* argv[]) {
+    if (argc < 5) {
+        std::cerr << "usage: geo --smooth-out-of-core <input.obj|raw> <output.obj|raw> <iterations> [chunk points]\n";
+        return 1;
+    }
+    try {
+        std::size_t chunkPoints = argc > 5 ? std::stoull(argv[5]) : std::size_t{1} << 20;
+        smoothFileOutOfCore(argv[2], argv[3], std::stoi(argv[4]), chunkPoints, [](double progress) {
+            std::cout << std::format("\rsmoothing {:.0f}%", 100.0 * progress) << std::flush;
+        });
+        std::cout << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << std::format("Error: {}\n", e.what());
+        return 1;
+    }
+    return 0;
+}
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    if (argc > 1 && std::string_view(argv[1]) == "--smooth-out-of-core") {
+        return smoothOutOfCore(argc, argv);
+    }
+    if (argc > 1 && std::string_view(argv[1]) == "--replay") {
+        if (argc < 3) {
+            std::cerr << "usage: geo --replay <session.log>\n";
+            return 1;
+        }
+        return replaySession(argv[2]);
+    }
 #ifdef __linux__
     SDL_SetHint(SDL_HINT_VIDEO_X11_FORCE_EGL, "1");
 #endif
     Application app;
     app.mainLoop();
     return 0;
-}
\ No newline at end of file
+}
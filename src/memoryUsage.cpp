@@ -0,0 +1,61 @@
+#include "memoryUsage.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+
+#include "HalfEdgeMesh.hpp"
+#include "deformations.hpp"
+#include "MeshGeometry.hpp"
+#include "PointGrid.hpp"
+#include "SpectralBasis.hpp"
+
+namespace {
+thread_local MemoryScope* currentScope = nullptr;
+std::atomic<std::size_t> ceiling = 0;
+std::mutex lastMutex;
+OperationMemory last;
+}  // namespace
+
+MemoryScope::MemoryScope(const char* name) : m_name(name), m_parent(currentScope) {
+    currentScope = this;
+    ScratchArena::acquire();
+}
+
+MemoryScope::~MemoryScope() {
+    currentScope = m_parent;
+    auto arena = ScratchArena::release();
+    if (m_parent == nullptr) {
+        std::lock_guard lock(lastMutex);
+        last = {m_name, m_peakBytes, arena};
+    }
+}
+
+void MemoryScope::observe(std::size_t bytes) {
+    for (auto scope = currentScope; scope != nullptr; scope = scope->m_parent) {
+        scope->m_peakBytes = std::max(scope->m_peakBytes, bytes);
+    }
+}
+
+OperationMemory lastOperationMemory() {
+    std::lock_guard lock(lastMutex);
+    return last;
+}
+
+void setMemoryCeiling(std::size_t bytes) { ceiling = bytes; }
+
+std::size_t memoryCeiling() { return ceiling; }
+
+bool exceedsMemoryCeiling(std::size_t predictedBytes) { return ceiling != 0 && predictedBytes > ceiling; }
+
+std::size_t meshArraysBytes(vtkPolyData* mesh) { return static_cast<std::size_t>(mesh->GetActualMemorySize()) * 1024; }
+
+std::size_t meshCachesBytes(vtkPolyData* mesh) {
+    std::size_t bytes = 0;
+    if (auto topology = HalfEdgeMesh::find(mesh)) bytes += topology->memoryBytes();
+    if (auto geometry = MeshGeometry::find(mesh)) bytes += geometry->memoryBytes();
+    if (auto basis = SpectralBasis::find(mesh)) bytes += basis->memoryBytes();
+    if (auto grid = PointGrid::find(mesh)) bytes += grid->memoryBytes();
+    bytes += implicitFairingCacheBytes(mesh);
+    return bytes;
+}
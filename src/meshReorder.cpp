@@ -0,0 +1,250 @@
+#include "meshReorder.hpp"
+
+#include <vtkCellArray.h>
+#include <vtkCellData.h>
+#include <vtkIdList.h>
+#include <vtkIdTypeArray.h>
+#include <vtkNew.h>
+#include <vtkPointData.h>
+#include <vtkPoints.h>
+#include <vtkSMPTools.h>
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <numeric>
+#include <stdexcept>
+#include <vector>
+
+#include "parallelSort.hpp"
+
+namespace {
+constexpr const char* originalPointIdsName = "vtkOriginalPointIds";
+constexpr const char* originalCellIdsName = "vtkOriginalCellIds";
+constexpr int mortonBits = 21;
+
+// spreads the 21 low bits of x so that they land on every third bit
+std::uint64_t spreadBits(std::uint64_t x) {
+    x &= (std::uint64_t{1} << mortonBits) - 1;
+    x = (x | x << 32) & 0x1f00000000ffffull;
+    x = (x | x << 16) & 0x1f0000ff0000ffull;
+    x = (x | x << 8) & 0x100f00f00f00f00full;
+    x = (x | x << 4) & 0x10c30c30c30c30c3ull;
+    x = (x | x << 2) & 0x1249249249249249ull;
+    return x;
+}
+
+struct SortKey {
+    std::uint64_t key;
+    vtkIdType id;
+};
+
+std::vector<vtkIdType> inverse(const std::vector<vtkIdType>& order) {
+    std::vector<vtkIdType> result(order.size());
+    vtkSMPTools::For(0, static_cast<vtkIdType>(order.size()), [&](vtkIdType begin, vtkIdType end) {
+        for (vtkIdType i = begin; i < end; ++i) result[order[i]] = i;
+    });
+    return result;
+}
+
+vtkNew<vtkIdList> makeIdList(const std::vector<vtkIdType>& ids) {
+    vtkNew<vtkIdList> list;
+    list->SetNumberOfIds(ids.size());
+    std::copy(ids.begin(), ids.end(), list->GetPointer(0));
+    return list;
+}
+
+vtkNew<vtkIdList> makeIotaList(vtkIdType size) {
+    vtkNew<vtkIdList> list;
+    list->SetNumberOfIds(size);
+    std::iota(list->GetPointer(0), list->GetPointer(0) + size, 0);
+    return list;
+}
+
+/**
+ * Copies the cells in the given order, an empty order keeps the cells in place, and renumbers their points.
+ */
+vtkSmartPointer<vtkCellArray> remapCells(vtkCellArray* cells, const std::vector<vtkIdType>& cellOrder,
+                                         const std::vector<vtkIdType>& newPointId) {
+    const vtkIdType nbCells = cells->GetNumberOfCells();
+    auto source = [&](vtkIdType c) { return cellOrder.empty() ? c : cellOrder[c]; };
+
+    vtkNew<vtkIdTypeArray> offsets;
+    offsets->SetNumberOfValues(nbCells + 1);
+    vtkIdType* offset = offsets->GetPointer(0);
+    offset[0] = 0;
+    for (vtkIdType c = 0; c < nbCells; ++c) offset[c + 1] = offset[c] + cells->GetCellSize(source(c));
+
+    vtkNew<vtkIdTypeArray> connectivity;
+    connectivity->SetNumberOfValues(offset[nbCells]);
+    vtkIdType* points = connectivity->GetPointer(0);
+    vtkSMPTools::For(0, nbCells, [&](vtkIdType begin, vtkIdType end) {
+        vtkNew<vtkIdList> ids;
+        for (vtkIdType c = begin; c < end; ++c) {
+            vtkIdType npts;
+            const vtkIdType* pts;
+            cells->GetCellAtId(source(c), npts, pts, ids);
+            std::transform(pts, pts + npts, points + offset[c], [&](vtkIdType p) { return newPointId[p]; });
+        }
+    });
+
+    auto result = vtkSmartPointer<vtkCellArray>::New();
+    result->SetData(offsets, connectivity);
+    return result;
+}
+
+/**
+ * @return the source of every cell of the output, the vertices, lines and strips stay in place and the polygons
+ * follow polyOrder.
+ */
+std::vector<vtkIdType> cellOrderOf(vtkPolyData* mesh, const std::vector<vtkIdType>& polyOrder) {
+    std::vector<vtkIdType> order(mesh->GetNumberOfCells());
+    std::iota(order.begin(), order.end(), 0);
+    const vtkIdType firstPoly = mesh->GetNumberOfVerts() + mesh->GetNumberOfLines();
+    std::transform(polyOrder.begin(), polyOrder.end(), order.begin() + firstPoly,
+                   [&](vtkIdType f) { return firstPoly + f; });
+    return order;
+}
+
+/**
+ * @param pointOrder The source of every point of the output.
+ * @param polyOrder The source of every polygon of the output.
+ */
+vtkSmartPointer<vtkPolyData> permuteMesh(vtkPolyData* mesh, const std::vector<vtkIdType>& pointOrder,
+                                         const std::vector<vtkIdType>& polyOrder) {
+    const vtkIdType nbPoints = pointOrder.size();
+    const auto newPointId = inverse(pointOrder);
+    auto output = vtkSmartPointer<vtkPolyData>::New();
+
+    auto pointIds = makeIdList(pointOrder);
+    auto outputPointIds = makeIotaList(nbPoints);
+    vtkNew<vtkPoints> points;
+    points->SetDataType(mesh->GetPoints()->GetDataType());
+    mesh->GetPoints()->GetPoints(pointIds, points);
+    output->SetPoints(points);
+    output->GetPointData()->CopyAllocate(mesh->GetPointData(), nbPoints);
+    output->GetPointData()->CopyData(mesh->GetPointData(), pointIds, outputPointIds);
+
+    output->SetVerts(remapCells(mesh->GetVerts(), {}, newPointId));
+    output->SetLines(remapCells(mesh->GetLines(), {}, newPointId));
+    output->SetPolys(remapCells(mesh->GetPolys(), polyOrder, newPointId));
+    output->SetStrips(remapCells(mesh->GetStrips(), {}, newPointId));
+
+    const vtkIdType nbCells = mesh->GetNumberOfCells();
+    auto cellIds = makeIdList(cellOrderOf(mesh, polyOrder));
+    auto outputCellIds = makeIotaList(nbCells);
+    output->GetCellData()->CopyAllocate(mesh->GetCellData(), nbCells);
+    output->GetCellData()->CopyData(mesh->GetCellData(), cellIds, outputCellIds);
+
+    output->GetFieldData()->ShallowCopy(mesh->GetFieldData());
+    return output;
+}
+}  // namespace
+
+vtkSmartPointer<vtkPolyData> reorderForLocality(vtkPolyData* mesh) {
+    const vtkIdType nbPoints = mesh->GetNumberOfPoints();
+    if (nbPoints == 0) {
+        auto output = vtkSmartPointer<vtkPolyData>::New();
+        output->ShallowCopy(mesh);
+        return output;
+    }
+    vtkPoints* meshPoints = mesh->GetPoints();
+
+    // points sorted by the Morton code of their position in the bounding box
+    double bounds[6];
+    meshPoints->GetBounds(bounds);
+    const double extent = std::max({bounds[1] - bounds[0], bounds[3] - bounds[2], bounds[5] - bounds[4]});
+    const double scale = extent > 0.0 ? static_cast<double>((1 << mortonBits) - 1) / extent : 0.0;
+    std::vector<SortKey> points(nbPoints);
+    vtkSMPTools::For(0, nbPoints, [&](vtkIdType begin, vtkIdType end) {
+        double p[3];
+        for (vtkIdType i = begin; i < end; ++i) {
+            meshPoints->GetPoint(i, p);
+            std::uint64_t code = 0;
+            for (int k = 0; k < 3; ++k) {
+                code |= spreadBits(static_cast<std::uint64_t>((p[k] - bounds[2 * k]) * scale)) << k;
+            }
+            points[i] = {code, i};
+        }
+    });
+    parallelRadixSort(points, [](const SortKey& k) { return k.key; }, 3 * mortonBits);
+    std::vector<vtkIdType> pointOrder(nbPoints);
+    std::transform(points.begin(), points.end(), pointOrder.begin(), [](const SortKey& k) { return k.id; });
+    const auto newPointId = inverse(pointOrder);
+
+    // polygons sorted by their first point in the new order
+    vtkCellArray* polys = mesh->GetPolys();
+    std::vector<SortKey> faces(polys->GetNumberOfCells());
+    vtkSMPTools::For(0, static_cast<vtkIdType>(faces.size()), [&](vtkIdType begin, vtkIdType end) {
+        vtkNew<vtkIdList> ids;
+        for (vtkIdType f = begin; f < end; ++f) {
+            vtkIdType npts;
+            const vtkIdType* pts;
+            polys->GetCellAtId(f, npts, pts, ids);
+            vtkIdType first = nbPoints;
+            for (vtkIdType k = 0; k < npts; ++k) first = std::min(first, newPointId[pts[k]]);
+            faces[f] = {static_cast<std::uint64_t>(first), f};
+        }
+    });
+    const int vertexBits = static_cast<int>(std::bit_width(static_cast<std::uint64_t>(nbPoints)));
+    parallelRadixSort(faces, [](const SortKey& k) { return k.key; }, vertexBits);
+    std::vector<vtkIdType> polyOrder(faces.size());
+    std::transform(faces.begin(), faces.end(), polyOrder.begin(), [](const SortKey& k) { return k.id; });
+
+    auto output = permuteMesh(mesh, pointOrder, polyOrder);
+    // the ids of a mesh that was already reordered were permuted with the other arrays
+    if (!output->GetPointData()->GetArray(originalPointIdsName)) {
+        vtkNew<vtkIdTypeArray> ids;
+        ids->SetName(originalPointIdsName);
+        ids->SetNumberOfValues(nbPoints);
+        std::copy(pointOrder.begin(), pointOrder.end(), ids->GetPointer(0));
+        output->GetPointData()->AddArray(ids);
+    }
+    if (!output->GetCellData()->GetArray(originalCellIdsName)) {
+        auto cellOrder = cellOrderOf(mesh, polyOrder);
+        vtkNew<vtkIdTypeArray> ids;
+        ids->SetName(originalCellIdsName);
+        ids->SetNumberOfValues(cellOrder.size());
+        std::copy(cellOrder.begin(), cellOrder.end(), ids->GetPointer(0));
+        output->GetCellData()->AddArray(ids);
+    }
+    return output;
+}
+
+vtkSmartPointer<vtkPolyData> restoreOriginalOrder(vtkPolyData* mesh) {
+    auto pointIds = vtkIdTypeArray::SafeDownCast(mesh->GetPointData()->GetArray(originalPointIdsName));
+    auto cellIds = vtkIdTypeArray::SafeDownCast(mesh->GetCellData()->GetArray(originalCellIdsName));
+    if (pointIds == nullptr || cellIds == nullptr) return mesh;
+
+    vtkSmartPointer<vtkPolyData> source = mesh;
+    if (cellIds->GetNumberOfValues() != mesh->GetNumberOfCells()) {
+        // the vertex cells added to draw the point colors have no cell data, they are left out
+        source = vtkSmartPointer<vtkPolyData>::New();
+        source->ShallowCopy(mesh);
+        source->SetVerts(vtkNew<vtkCellArray>());
+        if (cellIds->GetNumberOfValues() != source->GetNumberOfCells()) {
+            throw std::runtime_error("the cells of the mesh changed since it was reordered");
+        }
+    }
+
+    std::vector<vtkIdType> pointOrder(pointIds->GetNumberOfValues());
+    for (vtkIdType i = 0; i < static_cast<vtkIdType>(pointOrder.size()); ++i) pointOrder[pointIds->GetValue(i)] = i;
+
+    const vtkIdType firstPoly = source->GetNumberOfVerts() + source->GetNumberOfLines();
+    std::vector<vtkIdType> polyOrder(source->GetNumberOfPolys());
+    for (vtkIdType f = 0; f < static_cast<vtkIdType>(polyOrder.size()); ++f) {
+        polyOrder[cellIds->GetValue(firstPoly + f) - firstPoly] = f;
+    }
+
+    auto output = permuteMesh(source, pointOrder, polyOrder);
+    output->GetPointData()->RemoveArray(originalPointIdsName);
+    output->GetCellData()->RemoveArray(originalCellIdsName);
+    return output;
+}
+
+vtkIdType originalPointId(vtkPolyData* mesh, vtkIdType ptId) {
+    if (auto ids = vtkIdTypeArray::SafeDownCast(mesh->GetPointData()->GetArray(originalPointIdsName))) {
+        return ids->GetValue(ptId);
+    }
+    return ptId;
+}
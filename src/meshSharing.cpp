@@ -0,0 +1,224 @@
+#include "meshSharing.hpp"
+
+#include <vtkAbstractArray.h>
+#include <vtkCellArray.h>
+#include <vtkCellData.h>
+#include <vtkDataArray.h>
+#include <vtkNew.h>
+#include <vtkPointData.h>
+#include <vtkPoints.h>
+#include <vtkSMPTools.h>
+#include <vtkWeakPointer.h>
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "MappedFile.hpp"
+
+namespace {
+constexpr std::size_t hashBlockBytes = std::size_t{1} << 20;
+
+std::uint64_t mix(std::uint64_t h) {
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+std::uint64_t combine(std::uint64_t h, std::uint64_t value) { return mix(h ^ (value + 0x9e3779b97f4a7c15ULL)); }
+
+std::uint64_t hashBlock(const std::byte* data, std::size_t size) {
+    std::uint64_t h = 0;
+    std::size_t i = 0;
+    for (; i + sizeof(std::uint64_t) <= size; i += sizeof(std::uint64_t)) {
+        std::uint64_t word;
+        std::memcpy(&word, data + i, sizeof(word));
+        h = (h ^ word) * 0x100000001b3ULL + (h >> 29);
+    }
+    std::uint64_t tail = 0;
+    std::memcpy(&tail, data + i, size - i);
+    return mix(h ^ tail);
+}
+
+std::size_t arrayBytes(vtkDataArray* array) {
+    return static_cast<std::size_t>(array->GetNumberOfValues()) * array->GetDataTypeSize();
+}
+
+std::uint64_t hashArray(vtkDataArray* array) {
+    return combine(hashBytes(array->GetVoidPointer(0), arrayBytes(array)), array->GetDataType());
+}
+
+bool sameArray(vtkDataArray* a, vtkDataArray* b) {
+    return a->GetDataType() == b->GetDataType() && a->GetNumberOfComponents() == b->GetNumberOfComponents() &&
+           a->GetNumberOfValues() == b->GetNumberOfValues() &&
+           std::memcmp(a->GetVoidPointer(0), b->GetVoidPointer(0), arrayBytes(a)) == 0;
+}
+
+std::uint64_t hashCells(vtkCellArray* cells) {
+    return combine(hashArray(cells->GetOffsetsArray()), hashArray(cells->GetConnectivityArray()));
+}
+
+bool sameCells(vtkCellArray* a, vtkCellArray* b) {
+    return sameArray(a->GetOffsetsArray(), b->GetOffsetsArray()) &&
+           sameArray(a->GetConnectivityArray(), b->GetConnectivityArray());
+}
+
+/**
+ * An array shared by the meshes, it is only shared while a mesh uses it and it was not modified since it was loaded.
+ */
+template <typename T>
+struct SharedArray {
+    vtkWeakPointer<T> array;
+    vtkMTimeType mtime = 0;
+
+    SharedArray() = default;
+    explicit SharedArray(T* a) : array(a), mtime(a->GetMTime()) {}
+
+    T* get() const { return array != nullptr && array->GetMTime() == mtime ? array.Get() : nullptr; }
+};
+
+struct Attribute {
+    vtkWeakPointer<vtkAbstractArray> array;
+    int type;  // vtkDataSetAttributes::AttributeTypes, -1 for the other arrays
+};
+
+struct LoadedMesh {
+    SharedArray<vtkPoints> points;
+    SharedArray<vtkCellArray> polys;
+    std::vector<Attribute> pointArrays;
+    std::vector<Attribute> cellArrays;
+};
+
+std::mutex sharingMutex;
+std::unordered_map<std::uint64_t, LoadedMesh> meshesByKey;
+std::unordered_map<std::uint64_t, SharedArray<vtkPoints>> pointsByHash;
+std::unordered_map<std::uint64_t, SharedArray<vtkCellArray>> polysByHash;
+
+std::vector<Attribute> attributes(vtkDataSetAttributes* data) {
+    std::vector<Attribute> arrays;
+    for (int i = 0; i < data->GetNumberOfArrays(); ++i) {
+        arrays.push_back({data->GetAbstractArray(i), data->IsArrayAnAttribute(i)});
+    }
+    return arrays;
+}
+
+// false when one of the arrays is no longer used by any mesh
+bool addAttributes(const std::vector<Attribute>& arrays, vtkDataSetAttributes* data) {
+    for (const auto& attribute : arrays) {
+        if (attribute.array == nullptr) return false;
+        int index = data->AddArray(attribute.array);
+        if (attribute.type >= 0) data->SetActiveAttribute(index, attribute.type);
+    }
+    return true;
+}
+
+void pruneLocked() {
+    std::erase_if(meshesByKey, [](const auto& entry) {
+        return entry.second.points.get() == nullptr || entry.second.polys.get() == nullptr;
+    });
+    std::erase_if(pointsByHash, [](const auto& entry) { return entry.second.get() == nullptr; });
+    std::erase_if(polysByHash, [](const auto& entry) { return entry.second.get() == nullptr; });
+}
+}  // namespace
+
+std::uint64_t hashBytes(const void* data, std::size_t size) {
+    const auto* bytes = static_cast<const std::byte*>(data);
+    const auto nbBlocks = static_cast<vtkIdType>((size + hashBlockBytes - 1) / hashBlockBytes);
+    std::vector<std::uint64_t> blocks(nbBlocks);
+    vtkSMPTools::For(0, nbBlocks, [&](vtkIdType begin, vtkIdType end) {
+        for (vtkIdType b = begin; b < end; ++b) {
+            std::size_t offset = b * hashBlockBytes;
+            blocks[b] = hashBlock(bytes + offset, std::min(hashBlockBytes, size - offset));
+        }
+    });
+    std::uint64_t h = mix(size);
+    for (auto block : blocks) h = combine(h, block);
+    return h;
+}
+
+std::uint64_t meshKey(const std::filesystem::path& path, bool reorder) {
+    std::uint64_t h = 0;
+    if (std::filesystem::file_size(path) > 0) {
+        MappedFile file(path, MappedFile::Mode::Read);
+        h = hashBytes(file.at<std::byte>(0), file.size());
+    }
+    // the extension selects the reader
+    return combine(combine(h, std::hash<std::string>{}(path.extension().string())), reorder);
+}
+
+vtkSmartPointer<vtkPolyData> findSharedMesh(std::uint64_t key) {
+    std::lock_guard lock(sharingMutex);
+    pruneLocked();
+    auto search = meshesByKey.find(key);
+    if (search == meshesByKey.end()) return nullptr;
+    const auto& loaded = search->second;
+    auto mesh = vtkSmartPointer<vtkPolyData>::New();
+    mesh->SetPoints(loaded.points.get());
+    mesh->SetPolys(loaded.polys.get());
+    if (!addAttributes(loaded.pointArrays, mesh->GetPointData()) ||
+        !addAttributes(loaded.cellArrays, mesh->GetCellData())) {
+        meshesByKey.erase(search);
+        return nullptr;
+    }
+    return mesh;
+}
+
+MeshHashes hashMesh(vtkPolyData* mesh) {
+    if (mesh->GetPoints() == nullptr) return {};
+    return {hashArray(mesh->GetPoints()->GetData()), hashCells(mesh->GetPolys())};
+}
+
+vtkSmartPointer<vtkPolyData> shareMesh(std::uint64_t key, vtkSmartPointer<vtkPolyData> mesh) {
+    return shareMesh(key, mesh, hashMesh(mesh));
+}
+
+vtkSmartPointer<vtkPolyData> shareMesh(std::uint64_t key, vtkSmartPointer<vtkPolyData> mesh,
+                                       const MeshHashes& hashes) {
+    if (mesh->GetPoints() == nullptr || mesh->GetNumberOfVerts() > 0 || mesh->GetNumberOfLines() > 0 ||
+        mesh->GetNumberOfStrips() > 0) {
+        return mesh;
+    }
+    const auto pointsHash = hashes.points;
+    const auto polysHash = hashes.polys;
+
+    std::lock_guard lock(sharingMutex);
+    pruneLocked();
+    if (auto search = pointsByHash.find(pointsHash); search != pointsByHash.end()) {
+        vtkPoints* points = search->second.get();
+        if (points != mesh->GetPoints() && sameArray(points->GetData(), mesh->GetPoints()->GetData())) {
+            mesh->SetPoints(points);
+        }
+    } else {
+        pointsByHash.emplace(pointsHash, SharedArray<vtkPoints>(mesh->GetPoints()));
+    }
+    if (auto search = polysByHash.find(polysHash); search != polysByHash.end()) {
+        vtkCellArray* polys = search->second.get();
+        if (polys != mesh->GetPolys() && sameCells(polys, mesh->GetPolys())) {
+            mesh->SetPolys(polys);
+        }
+    } else {
+        polysByHash.emplace(polysHash, SharedArray<vtkCellArray>(mesh->GetPolys()));
+    }
+    meshesByKey[key] = {SharedArray<vtkPoints>(mesh->GetPoints()), SharedArray<vtkCellArray>(mesh->GetPolys()),
+                        attributes(mesh->GetPointData()), attributes(mesh->GetCellData())};
+    return mesh;
+}
+
+bool sharesPoints(vtkPolyData* mesh) {
+    // the polydata are the only owners of the points, the caches keep weak or raw pointers
+    return mesh->GetPoints() != nullptr && mesh->GetPoints()->GetReferenceCount() > 1;
+}
+
+void detachSharedPoints(vtkPolyData* mesh) {
+    if (!sharesPoints(mesh)) return;
+    vtkNew<vtkPoints> points;
+    points->DeepCopy(mesh->GetPoints());
+    mesh->SetPoints(points);
+}
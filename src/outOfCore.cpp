@@ -0,0 +1,546 @@
+#include "outOfCore.hpp"
+
+#include <vtkSMPTools.h>
+#include <vtkType.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cctype>
+#include <charconv>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <format>
+#include <fstream>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "MappedFile.hpp"
+#include "memoryUsage.hpp"
+
+namespace {
+constexpr char rawMagic[8] = {'G', 'E', 'O', 'R', 'A', 'W', '1', '\0'};
+// the grid the chunks are made of has at most 128 cells along an axis
+constexpr int gridBits = 7;
+// total size of the write buffers of the chunk files
+constexpr std::size_t chunkBuffersBytes = std::size_t{64} << 20;
+// the OBJ parser checks for a stop and reports its progress once per block of lines
+constexpr std::size_t linesPerBlock = 1 << 16;
+
+RawMeshHeader readHeader(const MappedFile& file, const std::filesystem::path& path) {
+    RawMeshHeader header{};
+    if (file.size() >= sizeof(RawMeshHeader)) std::memcpy(&header, file.at<std::byte>(0), sizeof(RawMeshHeader));
+    if (std::memcmp(header.magic, rawMagic, sizeof(rawMagic)) != 0 || header.fileSize() != file.size()) {
+        throw std::runtime_error(std::format("{} is not a raw mesh file", path.string()));
+    }
+    return header;
+}
+
+template <typename T>
+void writeValues(std::ofstream& out, const T* values, std::size_t count) {
+    out.write(reinterpret_cast<const char*>(values), static_cast<std::streamsize>(count * sizeof(T)));
+}
+
+std::vector<std::int64_t> readValues(const std::filesystem::path& path) {
+    std::vector<std::int64_t> values;
+    if (!std::filesystem::exists(path)) return values;
+    values.resize(std::filesystem::file_size(path) / sizeof(std::int64_t));
+    std::ifstream in(path, std::ios::binary);
+    in.read(reinterpret_cast<char*>(values.data()), static_cast<std::streamsize>(values.size() * sizeof(std::int64_t)));
+    if (!in) throw std::runtime_error(std::format("cannot read {}", path.string()));
+    return values;
+}
+
+void appendFile(std::ofstream& out, const std::filesystem::path& path) {
+    if (std::filesystem::file_size(path) == 0) return;
+    std::ifstream in(path, std::ios::binary);
+    out << in.rdbuf();
+}
+
+std::uint32_t spreadBits(std::uint32_t x) {
+    std::uint32_t result = 0;
+    for (int b = 0; b < gridBits; ++b) result |= ((x >> b) & 1u) << (3 * b);
+    return result;
+}
+
+/**
+ * Spatial partition of the points, the cells of a grid over the bounding box are grouped in chunks along a Morton
+ * curve, so that a chunk is a compact region holding at most the requested number of points.
+ * A cell holding more points than a chunk gets consecutive chunks of its own, its points are split between them in the
+ * order of their ids.
+ */
+struct Partition {
+    std::array<double, 3> origin;
+    std::array<double, 3> inverseCellSize;
+    std::array<int, 3> dims;
+    std::vector<std::int32_t> chunkOfCell;  // the first chunk of the cell
+    std::size_t chunkPoints = 1;
+    std::int32_t nbChunks = 0;
+
+    std::size_t cellOf(const double* p) const {
+        std::array<int, 3> cell;
+        for (int k = 0; k < 3; ++k) {
+            cell[k] = std::clamp(static_cast<int>((p[k] - origin[k]) * inverseCellSize[k]), 0, dims[k] - 1);
+        }
+        return (static_cast<std::size_t>(cell[2]) * dims[1] + cell[1]) * dims[0] + cell[0];
+    }
+};
+
+Partition partitionPoints(const double* points, std::uint64_t nbPoints, std::size_t chunkPoints) {
+    Partition partition;
+    partition.chunkPoints = chunkPoints;
+    std::array<double, 3> lo, hi;
+    lo.fill(std::numeric_limits<double>::max());
+    hi.fill(std::numeric_limits<double>::lowest());
+    for (std::uint64_t i = 0; i < nbPoints; ++i) {
+        for (int k = 0; k < 3; ++k) {
+            lo[k] = std::min(lo[k], points[3 * i + k]);
+            hi[k] = std::max(hi[k], points[3 * i + k]);
+        }
+    }
+    double extent = 0.0;
+    for (int k = 0; k < 3; ++k) extent = std::max(extent, hi[k] - lo[k]);
+    // cells as cubic as possible, a flat scan gets a flat grid
+    for (int k = 0; k < 3; ++k) {
+        double size = hi[k] - lo[k];
+        partition.dims[k] = extent > 0.0 ? std::clamp(static_cast<int>(std::ceil(size / extent * (1 << gridBits))),
+                                                      1, 1 << gridBits)
+                                         : 1;
+        partition.origin[k] = nbPoints > 0 ? lo[k] : 0.0;
+        partition.inverseCellSize[k] = size > 0.0 ? partition.dims[k] / size : 0.0;
+    }
+
+    const std::size_t nbCells = static_cast<std::size_t>(partition.dims[0]) * partition.dims[1] * partition.dims[2];
+    std::vector<std::uint64_t> counts(nbCells, 0);
+    for (std::uint64_t i = 0; i < nbPoints; ++i) ++counts[partition.cellOf(points + 3 * i)];
+
+    std::vector<std::uint32_t> cells(nbCells);
+    std::iota(cells.begin(), cells.end(), 0u);
+    auto morton = [&](std::uint32_t cell) {
+        std::uint32_t x = cell % partition.dims[0];
+        std::uint32_t y = (cell / partition.dims[0]) % partition.dims[1];
+        std::uint32_t z = cell / (partition.dims[0] * partition.dims[1]);
+        return spreadBits(x) | spreadBits(y) << 1 | spreadBits(z) << 2;
+    };
+    std::ranges::sort(cells, {}, morton);
+
+    partition.chunkOfCell.resize(nbCells);
+    std::uint64_t filled = 0;
+    std::int32_t chunk = 0;
+    for (auto cell : cells) {
+        if (filled > 0 && filled + counts[cell] > chunkPoints) {
+            ++chunk;
+            filled = 0;
+        }
+        partition.chunkOfCell[cell] = chunk;
+        if (counts[cell] > chunkPoints) {
+            chunk += static_cast<std::int32_t>((counts[cell] - 1) / chunkPoints);
+            filled = chunkPoints;
+        } else {
+            filled += counts[cell];
+        }
+    }
+    partition.nbChunks = chunk + 1;
+    return partition;
+}
+
+std::filesystem::path chunkFilePath(const std::filesystem::path& directory, vtkIdType chunk, std::string_view suffix) {
+    return directory / std::format("{}.{}", chunk, suffix);
+}
+
+/**
+ * Appends values to one file per chunk, the buffers of all the chunks share a bounded budget.
+ */
+class ChunkFiles {
+   public:
+    ChunkFiles(std::filesystem::path directory, std::string suffix, std::int32_t nbChunks)
+        : m_directory(std::move(directory)),
+          m_suffix(std::move(suffix)),
+          m_buffers(nbChunks),
+          m_threshold(std::max<std::size_t>(1024, chunkBuffersBytes / sizeof(std::int64_t) / nbChunks)) {}
+
+    std::filesystem::path path(std::int32_t chunk) const { return chunkFilePath(m_directory, chunk, m_suffix); }
+
+    void append(std::int32_t chunk, const std::int64_t* values, std::size_t count) {
+        auto& buffer = m_buffers[chunk];
+        buffer.insert(buffer.end(), values, values + count);
+        if (buffer.size() >= m_threshold) flush(chunk);
+    }
+
+    void flushAll() {
+        for (std::int32_t chunk = 0; chunk < static_cast<std::int32_t>(m_buffers.size()); ++chunk) flush(chunk);
+    }
+
+   private:
+    void flush(std::int32_t chunk) {
+        auto& buffer = m_buffers[chunk];
+        if (buffer.empty()) return;
+        std::ofstream out(path(chunk), std::ios::binary | std::ios::app);
+        writeValues(out, buffer.data(), buffer.size());
+        if (!out) throw std::runtime_error(std::format("cannot write {}", path(chunk).string()));
+        buffer.clear();
+    }
+
+    std::filesystem::path m_directory;
+    std::string m_suffix;
+    std::vector<std::vector<std::int64_t>> m_buffers;
+    std::size_t m_threshold;
+};
+
+/**
+ * Builds the adjacency of the points of a chunk from the faces touching them, stored as
+ * [nbOwned, nbHalo, owned ids..., halo ids..., offsets(nbOwned + 1)..., neighbors...], the halo being the neighbors
+ * outside of the chunk and the neighbors indices into the owned and halo ids.
+ *
+ * @return the peak bytes used.
+ */
+std::size_t buildChunkAdjacency(const std::filesystem::path& pointsPath, const std::filesystem::path& facesPath,
+                                const std::filesystem::path& adjacencyPath, std::int64_t nbPoints) {
+    auto owned = readValues(pointsPath);
+    auto faces = readValues(facesPath);
+    auto ownedIndex = [&](std::int64_t id) -> std::int64_t {
+        auto search = std::ranges::lower_bound(owned, id);
+        return search != owned.end() && *search == id ? search - owned.begin() : -1;
+    };
+    std::vector<std::pair<std::int64_t, std::int64_t>> pairs;
+    for (std::size_t i = 0; i < faces.size(); i += faces[i] + 1) {
+        const std::int64_t* face = faces.data() + i + 1;
+        const std::int64_t n = faces[i];
+        for (std::int64_t k = 0; k < n; ++k) {
+            if (face[k] < 0 || face[k] >= nbPoints) {
+                throw std::runtime_error(std::format("the neighbor {} is not one of the {} points", face[k], nbPoints));
+            }
+            std::int64_t local = ownedIndex(face[k]);
+            if (local < 0) continue;
+            pairs.emplace_back(local, face[(k + n - 1) % n]);
+            pairs.emplace_back(local, face[(k + 1) % n]);
+        }
+    }
+    std::ranges::sort(pairs);
+    pairs.erase(std::unique(pairs.begin(), pairs.end()), pairs.end());
+
+    std::vector<std::int64_t> halo;
+    for (const auto& pair : pairs) {
+        if (ownedIndex(pair.second) < 0) halo.push_back(pair.second);
+    }
+    std::ranges::sort(halo);
+    halo.erase(std::unique(halo.begin(), halo.end()), halo.end());
+
+    std::vector<std::int64_t> adjacency;
+    adjacency.reserve(3 + 2 * owned.size() + halo.size() + pairs.size());
+    adjacency.push_back(owned.size());
+    adjacency.push_back(halo.size());
+    adjacency.insert(adjacency.end(), owned.begin(), owned.end());
+    adjacency.insert(adjacency.end(), halo.begin(), halo.end());
+    std::size_t offsetsStart = adjacency.size();
+    adjacency.resize(offsetsStart + owned.size() + 1, 0);
+    for (const auto& pair : pairs) ++adjacency[offsetsStart + pair.first + 1];
+    std::partial_sum(adjacency.begin() + offsetsStart, adjacency.end(), adjacency.begin() + offsetsStart);
+    for (const auto& pair : pairs) {
+        std::int64_t local = ownedIndex(pair.second);
+        adjacency.push_back(local >= 0 ? local
+                                       : static_cast<std::int64_t>(owned.size()) +
+                                             (std::ranges::lower_bound(halo, pair.second) - halo.begin()));
+    }
+
+    std::ofstream out(adjacencyPath, std::ios::binary | std::ios::trunc);
+    writeValues(out, adjacency.data(), adjacency.size());
+    if (!out) throw std::runtime_error(std::format("cannot write {}", adjacencyPath.string()));
+    std::filesystem::remove(pointsPath);
+    std::filesystem::remove(facesPath);
+    return containerBytes(faces) + containerBytes(pairs) + containerBytes(adjacency) + containerBytes(owned) +
+           containerBytes(halo);
+}
+
+/**
+ * One smoothing iteration of the points of a chunk, the previous positions of its points and of their halo are
+ * gathered in a local buffer, and only the new positions of its own points are written.
+ *
+ * @return the bytes of the adjacency and of the positions of the chunk.
+ */
+std::size_t smoothChunk(const std::int64_t* adjacency, const double* previous, double* next) {
+    const std::int64_t nbOwned = adjacency[0];
+    const std::int64_t nbLocal = nbOwned + adjacency[1];
+    const std::int64_t* ids = adjacency + 2;
+    const std::int64_t* offsets = ids + nbLocal;
+    const std::int64_t* neighbors = offsets + nbOwned + 1;
+    std::vector<double> local(3 * nbLocal);
+    for (std::int64_t i = 0; i < nbLocal; ++i) {
+        std::memcpy(local.data() + 3 * i, previous + 3 * ids[i], 3 * sizeof(double));
+    }
+    for (std::int64_t i = 0; i < nbOwned; ++i) {
+        const double* position = local.data() + 3 * i;
+        const std::int64_t numNeighbors = offsets[i + 1] - offsets[i];
+        double sum[3] = {position[0], position[1], position[2]};
+        for (std::int64_t j = offsets[i]; j < offsets[i + 1]; ++j) {
+            for (int k = 0; k < 3; ++k) sum[k] += local[3 * neighbors[j] + k];
+        }
+        double* newPosition = next + 3 * ids[i];
+        for (int k = 0; k < 3; ++k) newPosition[k] = sum[k] / (numNeighbors + 1);
+    }
+    return containerBytes(local) + (2 + nbLocal + nbOwned + 1 + offsets[nbOwned]) * sizeof(std::int64_t);
+}
+
+bool isObjFile(const std::filesystem::path& path) { return path.extension() == ".obj"; }
+
+std::filesystem::path withSuffix(std::filesystem::path path, const char* suffix) { return path += suffix; }
+}  // namespace
+
+bool parseObj(const std::filesystem::path& objPath, const std::function<void(const double*)>& point,
+              const std::function<void(std::span<const std::int64_t>)>& face,
+              const std::function<void(double)>& progress, std::stop_token stopToken) {
+    std::ifstream obj(objPath);
+    if (!obj) throw std::runtime_error(std::format("cannot open {}", objPath.string()));
+    std::error_code error;
+    const double bytes = static_cast<double>(std::max<std::uintmax_t>(std::filesystem::file_size(objPath, error), 1));
+    std::uintmax_t consumed = 0;
+    std::int64_t nbPoints = 0;
+
+    std::string line;
+    std::vector<std::int64_t> indices;
+    for (std::size_t lines = 0; std::getline(obj, line); ++lines) {
+        if (lines % linesPerBlock == 0) {
+            if (stopToken.stop_requested()) return false;
+            if (progress) progress(std::min(static_cast<double>(consumed) / bytes, 1.0));
+        }
+        consumed += line.size() + 1;
+        if (line.starts_with("v ")) {
+            double p[3] = {0.0, 0.0, 0.0};
+            const char* c = line.c_str() + 2;
+            for (int k = 0; k < 3; ++k) {
+                char* end;
+                p[k] = std::strtod(c, &end);
+                c = end;
+            }
+            point(p);
+            ++nbPoints;
+        } else if (line.starts_with("f ")) {
+            indices.clear();
+            const char* c = line.data() + 2;
+            const char* last = line.data() + line.size();
+            while (c < last) {
+                while (c < last && std::isspace(static_cast<unsigned char>(*c))) ++c;
+                std::int64_t index = 0;
+                auto [next, error] = std::from_chars(c, last, index);
+                if (error != std::errc()) break;
+                // indices start at 1, negative indices count back from the last point
+                indices.push_back(index < 0 ? nbPoints + index : index - 1);
+                // skips the texture and normal indices
+                c = next;
+                while (c < last && !std::isspace(static_cast<unsigned char>(*c))) ++c;
+            }
+            if (indices.size() >= 3) face(indices);
+        }
+    }
+    if (progress) progress(1.0);
+    return true;
+}
+
+void convertObjToRaw(const std::filesystem::path& objPath, const std::filesystem::path& rawPath) {
+    if (!std::ifstream(objPath)) throw std::runtime_error(std::format("cannot open {}", objPath.string()));
+    // the points are written in place, the faces go through temporary files appended at the end
+    const auto offsetsPath = withSuffix(rawPath, ".offsets.tmp");
+    const auto connectivityPath = withSuffix(rawPath, ".connectivity.tmp");
+    std::ofstream raw(rawPath, std::ios::binary | std::ios::trunc);
+    std::ofstream offsets(offsetsPath, std::ios::binary | std::ios::trunc);
+    std::ofstream connectivity(connectivityPath, std::ios::binary | std::ios::trunc);
+
+    RawMeshHeader header{};
+    std::memcpy(header.magic, rawMagic, sizeof(rawMagic));
+    writeValues(raw, &header, 1);
+    std::int64_t offset = 0;
+    writeValues(offsets, &offset, 1);
+
+    parseObj(
+        objPath,
+        [&](const double* p) {
+            writeValues(raw, p, 3);
+            ++header.nbPoints;
+        },
+        [&](std::span<const std::int64_t> face) {
+            writeValues(connectivity, face.data(), face.size());
+            offset += face.size();
+            writeValues(offsets, &offset, 1);
+            ++header.nbFaces;
+            header.nbConnectivity += face.size();
+        });
+    offsets.close();
+    connectivity.close();
+    appendFile(raw, offsetsPath);
+    appendFile(raw, connectivityPath);
+    raw.seekp(0);
+    writeValues(raw, &header, 1);
+    raw.close();
+    std::filesystem::remove(offsetsPath);
+    std::filesystem::remove(connectivityPath);
+    if (!raw) throw std::runtime_error(std::format("cannot write {}", rawPath.string()));
+}
+
+void convertRawToObj(const std::filesystem::path& rawPath, const std::filesystem::path& objPath) {
+    MappedFile raw(rawPath, MappedFile::Mode::Read);
+    const auto header = readHeader(raw, rawPath);
+    const double* points = raw.at<double>(header.pointsOffset());
+    const std::int64_t* offsets = raw.at<std::int64_t>(header.offsetsOffset());
+    const std::int64_t* connectivity = raw.at<std::int64_t>(header.connectivityOffset());
+
+    std::ofstream obj(objPath, std::ios::trunc);
+    std::string buffer;
+    auto flush = [&](std::size_t threshold) {
+        if (buffer.size() < threshold) return;
+        obj.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+        buffer.clear();
+    };
+    for (std::uint64_t i = 0; i < header.nbPoints; ++i) {
+        buffer += std::format("v {} {} {}\n", points[3 * i], points[3 * i + 1], points[3 * i + 2]);
+        flush(1 << 20);
+    }
+    for (std::uint64_t f = 0; f < header.nbFaces; ++f) {
+        buffer += "f";
+        for (auto k = offsets[f]; k < offsets[f + 1]; ++k) buffer += std::format(" {}", connectivity[k] + 1);
+        buffer += "\n";
+        flush(1 << 20);
+    }
+    flush(0);
+    if (!obj) throw std::runtime_error(std::format("cannot write {}", objPath.string()));
+}
+
+void laplacianSmoothingOutOfCore(const std::filesystem::path& inputPath, const std::filesystem::path& outputPath,
+                                 int numIterations, std::size_t chunkPoints,
+                                 const std::function<void(double)>& progress) {
+    MemoryScope scope("laplacianSmoothingOutOfCore");
+    if (std::filesystem::exists(outputPath) && std::filesystem::equivalent(inputPath, outputPath)) {
+        throw std::runtime_error("the output of the out-of-core smoothing must differ from its input");
+    }
+    // the output starts as a copy of the input, its points are the positions of the even iterations
+    std::filesystem::copy_file(inputPath, outputPath, std::filesystem::copy_options::overwrite_existing);
+    MappedFile output(outputPath, MappedFile::Mode::ReadWrite);
+    const auto header = readHeader(output, outputPath);
+    double* positions = output.at<double>(header.pointsOffset());
+    const std::int64_t* offsets = output.at<std::int64_t>(header.offsetsOffset());
+    const std::int64_t* connectivity = output.at<std::int64_t>(header.connectivityOffset());
+
+    const auto directory = withSuffix(outputPath, ".chunks");
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory);
+
+    // owned points and faces of every chunk, a face goes to every chunk owning one of its points
+    const auto nbPoints = static_cast<std::int64_t>(header.nbPoints);
+    const auto nbConnectivity = static_cast<std::int64_t>(header.nbConnectivity);
+    const auto partition = partitionPoints(positions, header.nbPoints, std::max<std::size_t>(chunkPoints, 1));
+    {
+        // the chunk of every point, on disk as the points
+        const auto chunksPath = directory / "chunks";
+        MappedFile::create(chunksPath, header.nbPoints * sizeof(std::int32_t));
+        MappedFile chunks(chunksPath, MappedFile::Mode::ReadWrite);
+        std::int32_t* chunkOfPoint = chunks.at<std::int32_t>(0);
+
+        std::vector<std::uint64_t> placed(partition.chunkOfCell.size(), 0);
+        MemoryScope::observe(containerBytes(partition.chunkOfCell) + containerBytes(placed) + chunkBuffersBytes);
+        ChunkFiles pointFiles(directory, "points", partition.nbChunks);
+        for (std::int64_t i = 0; i < nbPoints; ++i) {
+            const auto cell = partition.cellOf(positions + 3 * i);
+            const auto split = static_cast<std::int32_t>(placed[cell]++ / partition.chunkPoints);
+            chunkOfPoint[i] = partition.chunkOfCell[cell] + split;
+            pointFiles.append(chunkOfPoint[i], &i, 1);
+        }
+        pointFiles.flushAll();
+
+        ChunkFiles faceFiles(directory, "faces", partition.nbChunks);
+        std::vector<std::int64_t> record;
+        std::vector<std::int32_t> faceChunks;
+        for (std::uint64_t f = 0; f < header.nbFaces; ++f) {
+            if (offsets[f] < 0 || offsets[f + 1] < offsets[f] || offsets[f + 1] > nbConnectivity) {
+                throw std::runtime_error(std::format("the face {} of {} is out of its connectivity", f,
+                                                     inputPath.string()));
+            }
+            record.assign(1, offsets[f + 1] - offsets[f]);
+            faceChunks.clear();
+            for (auto k = offsets[f]; k < offsets[f + 1]; ++k) {
+                if (connectivity[k] < 0 || connectivity[k] >= nbPoints) {
+                    throw std::runtime_error(std::format("the face {} of {} uses the point {} of {}", f,
+                                                         inputPath.string(), connectivity[k], nbPoints));
+                }
+                record.push_back(connectivity[k]);
+                faceChunks.push_back(chunkOfPoint[connectivity[k]]);
+            }
+            std::ranges::sort(faceChunks);
+            faceChunks.erase(std::unique(faceChunks.begin(), faceChunks.end()), faceChunks.end());
+            for (auto chunk : faceChunks) faceFiles.append(chunk, record.data(), record.size());
+        }
+        faceFiles.flushAll();
+    }
+    auto chunkPath = [&](vtkIdType chunk, std::string_view suffix) { return chunkFilePath(directory, chunk, suffix); };
+
+    std::atomic<std::size_t> chunkPeak = 0;
+    auto observeChunk = [&](std::size_t bytes) {
+        auto peak = chunkPeak.load();
+        while (bytes > peak && !chunkPeak.compare_exchange_weak(peak, bytes)) {
+        }
+    };
+    vtkSMPTools::For(0, partition.nbChunks, 1, [&](vtkIdType begin, vtkIdType end) {
+        for (auto chunk = begin; chunk < end; ++chunk) {
+            observeChunk(buildChunkAdjacency(chunkPath(chunk, "points"), chunkPath(chunk, "faces"),
+                                             chunkPath(chunk, "adjacency"), nbPoints));
+        }
+    });
+
+    // the adjacencies of the chunks are gathered in a single file mapped once for all the iterations
+    const auto adjacencyPath = directory / "adjacency";
+    std::vector<std::size_t> adjacencyStart(partition.nbChunks + 1, 0);
+    {
+        std::ofstream out(adjacencyPath, std::ios::binary | std::ios::trunc);
+        for (std::int32_t chunk = 0; chunk < partition.nbChunks; ++chunk) {
+            const auto path = chunkPath(chunk, "adjacency");
+            adjacencyStart[chunk + 1] = adjacencyStart[chunk] + std::filesystem::file_size(path) / sizeof(std::int64_t);
+            appendFile(out, path);
+            std::filesystem::remove(path);
+        }
+        if (!out) throw std::runtime_error(std::format("cannot write {}", adjacencyPath.string()));
+    }
+
+    {
+        MappedFile adjacency(adjacencyPath, MappedFile::Mode::Read);
+        // the other buffer of positions, the positions of the odd iterations
+        const std::size_t positionsBytes = 3 * header.nbPoints * sizeof(double);
+        const auto swapPath = directory / "positions";
+        MappedFile::create(swapPath, positionsBytes);
+        MappedFile swap(swapPath, MappedFile::Mode::ReadWrite);
+        double* previous = positions;
+        double* next = swap.at<double>(0);
+        for (int i = 0; i < numIterations; ++i) {
+            // every chunk reads the positions of its halo from the previous iteration, so the chunks are independent
+            vtkSMPTools::For(0, partition.nbChunks, 1, [&](vtkIdType begin, vtkIdType end) {
+                for (auto chunk = begin; chunk < end; ++chunk) {
+                    const auto* chunkAdjacency = adjacency.at<std::int64_t>(adjacencyStart[chunk] *
+                                                                             sizeof(std::int64_t));
+                    observeChunk(smoothChunk(chunkAdjacency, previous, next));
+                }
+            });
+            std::swap(previous, next);
+            MemoryScope::observe(containerBytes(partition.chunkOfCell) + containerBytes(adjacencyStart) +
+                                 chunkPeak * vtkSMPTools::GetEstimatedNumberOfThreads());
+            if (progress) progress(static_cast<double>(i + 1) / numIterations);
+        }
+        if (previous != positions && positionsBytes > 0) std::memcpy(positions, previous, positionsBytes);
+        output.flush();
+    }
+    std::filesystem::remove_all(directory);
+}
+
+void smoothFileOutOfCore(const std::filesystem::path& inputPath, const std::filesystem::path& outputPath,
+                         int numIterations, std::size_t chunkPoints, const std::function<void(double)>& progress) {
+    auto rawInput = isObjFile(inputPath) ? withSuffix(outputPath, ".input.raw") : inputPath;
+    auto rawOutput = isObjFile(outputPath) ? withSuffix(outputPath, ".output.raw") : outputPath;
+    if (rawInput != inputPath) convertObjToRaw(inputPath, rawInput);
+    laplacianSmoothingOutOfCore(rawInput, rawOutput, numIterations, chunkPoints, progress);
+    if (rawInput != inputPath) std::filesystem::remove(rawInput);
+    if (rawOutput != outputPath) {
+        convertRawToObj(rawOutput, outputPath);
+        std::filesystem::remove(rawOutput);
+    }
+}
@@ -0,0 +1,249 @@
+#include "sessionReplay.hpp"
+
+#include <vtkPolyData.h>
+#include <vtkSmartPointer.h>
+
+#include <algorithm>
+#include <chrono>
+#include <exception>
+#include <format>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "BatchRunner.hpp"
+#include "SessionLog.hpp"
+#include "colorize.hpp"
+#include "deformations.hpp"
+#include "fileIO.hpp"
+#include "harmonicFn.hpp"
+#include "memoryUsage.hpp"
+
+namespace {
+// the colors do not change the cost of the colorization
+constexpr float colorNeutral[3] = {1.0f, 1.0f, 1.0f};
+constexpr float colorStart[3] = {1.0f, 0.0f, 0.0f};
+constexpr float colorEnd[3] = {0.0f, 0.0f, 1.0f};
+
+struct StageTotal {
+    int count = 0;
+    double seconds = 0.0;
+};
+
+class Replay {
+   public:
+    void run(const SessionAction& action) {
+        m_stages.clear();
+        switch (action.type) {
+            case SessionAction::Type::Open:
+                timed("load", [&] {
+                    auto mesh = loadMesh(action.name, action.reorder);
+                    if (mesh == nullptr) throw std::runtime_error(std::format("unknown file type {}", action.name));
+                    m_meshes[std::filesystem::path(action.name).filename().string()] = mesh;
+                });
+                break;
+            case SessionAction::Type::Pick:
+                m_picked = mesh(action.name);
+                m_pointId = action.pointId;
+                if (m_pointId < 0 || m_pointId >= m_picked->GetNumberOfPoints()) {
+                    throw std::runtime_error(std::format("point {} is not in {}", m_pointId, action.name));
+                }
+                break;
+            case SessionAction::Type::Weight: {
+                auto polyData = picked();
+                std::vector<float> weights;
+                timed("weighting",
+                      [&] { weights = weightingValues(action.method, polyData, m_pointId, action.ringCount,
+                                                      action.alpha, action.modes, action.radius); });
+                timed("colorize", [&] {
+                    colorizeWeights(polyData, m_pointId, weights, colorNeutral, colorStart, colorEnd);
+                });
+                break;
+            }
+            case SessionAction::Type::Translate: {
+                auto polyData = picked();
+                std::function<double(vtkIdType)> harmonic;
+                timed("weighting",
+                      [&] { harmonic = weightingFunction(action.method, polyData, m_pointId, action.ringCount,
+                                                         action.alpha, action.modes, action.radius); });
+                timed("translate", [&] {
+                    auto support =
+                        weightingSupport(action.method, polyData, m_pointId, action.ringCount, action.radius);
+                    weightedTranslate(polyData, m_pointId, action.distance, harmonic, support);
+                });
+                break;
+            }
+            case SessionAction::Type::Smooth: {
+                auto polyData = mesh(action.name);
+                timed("smooth", [&] { laplacianSmoothing(polyData, action.iterations); });
+                break;
+            }
+            case SessionAction::Type::Fair: {
+                auto polyData = mesh(action.name);
+                auto weights = static_cast<FairingWeights>(action.weights);
+                timed("fairing", [&] { implicitFairing(polyData, action.stepSize, weights, action.biLaplacian); });
+                break;
+            }
+            case SessionAction::Type::Batch: {
+                std::vector<std::pair<std::string, vtkPolyData*>> meshes;
+                for (const auto& name : action.names) meshes.emplace_back(name, mesh(name));
+                timed("batch", [&] { runBatch(action, meshes); });
+                break;
+            }
+        }
+    }
+
+    /**
+     * @return the stages of the last operation with their duration in seconds
+     */
+    const std::vector<std::pair<std::string, double>>& stages() const { return m_stages; }
+    const std::map<std::string, StageTotal>& totals() const { return m_totals; }
+
+   private:
+    template <typename F>
+    void timed(const std::string& stage, F&& f) {
+        auto start = std::chrono::steady_clock::now();
+        f();
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        m_stages.emplace_back(stage, seconds);
+        auto& total = m_totals[stage];
+        ++total.count;
+        total.seconds += seconds;
+    }
+
+    // the batch of Tools::batchSection, its results are applied as the interface does between two frames
+    static void runBatch(const SessionAction& action, const std::vector<std::pair<std::string, vtkPolyData*>>& meshes) {
+        BatchRunner batch;
+        if (action.operation == 0) {
+            batch.run(meshes, [iterations = action.iterations](vtkPolyData* mesh, const auto& progress) {
+                laplacianSmoothing(mesh, iterations, progress);
+            });
+        } else {
+            batch.run(meshes, [&action](vtkPolyData* mesh, const auto& progress) {
+                vtkIdType pointId = std::min<vtkIdType>(action.pointId, mesh->GetNumberOfPoints() - 1);
+                if (pointId < 0) return;
+                auto weights = weightingValues(1, mesh, pointId, action.iterations, action.alpha, 0, 0.0, progress);
+                colorizeWeights(mesh, pointId, weights, colorNeutral, colorStart, colorEnd);
+            });
+        }
+        while (batch.running()) {
+            batch.applyFinished();
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        batch.applyFinished();
+    }
+
+    vtkPolyData* mesh(const std::string& name) const {
+        auto search = m_meshes.find(name);
+        if (search == m_meshes.end()) throw std::runtime_error(std::format("no mesh {} was opened", name));
+        return search->second;
+    }
+
+    vtkPolyData* picked() const {
+        if (m_picked == nullptr) throw std::runtime_error("no point was picked");
+        return m_picked;
+    }
+
+    std::map<std::string, vtkSmartPointer<vtkPolyData>> m_meshes;
+    vtkPolyData* m_picked = nullptr;
+    vtkIdType m_pointId = -1;
+    std::vector<std::pair<std::string, double>> m_stages;
+    std::map<std::string, StageTotal> m_totals;
+};
+
+const char* typeName(SessionAction::Type type) {
+    switch (type) {
+        case SessionAction::Type::Open:
+            return "open";
+        case SessionAction::Type::Pick:
+            return "pick";
+        case SessionAction::Type::Weight:
+            return "weight";
+        case SessionAction::Type::Translate:
+            return "translate";
+        case SessionAction::Type::Smooth:
+            return "smooth";
+        case SessionAction::Type::Fair:
+            return "fair";
+        case SessionAction::Type::Batch:
+            return "batch";
+    }
+    return "";
+}
+
+std::string parameters(const SessionAction& action) {
+    switch (action.type) {
+        case SessionAction::Type::Open:
+            return std::filesystem::path(action.name).filename().string();
+        case SessionAction::Type::Pick:
+            return std::format("{} {}", action.name, action.pointId);
+        case SessionAction::Type::Weight:
+            return std::format("method {} rings {} alpha {} modes {} radius {}", action.method, action.ringCount,
+                               action.alpha, action.modes, action.radius);
+        case SessionAction::Type::Translate:
+            return std::format("method {} rings {} alpha {} modes {} radius {} distance {}", action.method,
+                               action.ringCount, action.alpha, action.modes, action.radius, action.distance);
+        case SessionAction::Type::Smooth:
+            return std::format("{} {} iterations", action.name, action.iterations);
+        case SessionAction::Type::Fair:
+            return std::format("{} step {} {}{}", action.name, action.stepSize,
+                               action.weights == 0 ? "uniform" : "cotangent", action.biLaplacian ? " bi-laplacian" : "");
+        case SessionAction::Type::Batch:
+            if (action.operation == 0) {
+                return std::format("smooth {} actors {} iterations", action.names.size(), action.iterations);
+            }
+            return std::format("diffuse {} actors seed {} iterations {} alpha {}", action.names.size(), action.pointId,
+                               action.iterations, action.alpha);
+    }
+    return "";
+}
+
+double toMiB(std::size_t bytes) { return static_cast<double>(bytes) / (1024.0 * 1024.0); }
+}  // namespace
+
+int replaySession(const std::filesystem::path& logPath) {
+    try {
+        auto actions = readSessionLog(logPath);
+        std::cout << std::format("replaying {} operations of {}\n", actions.size(), logPath.string());
+        std::cout << std::format("{:>4}  {:<10} {:<44} {:>10} {:>10} {:>12} {:>6}  {}\n", "#", "operation",
+                                 "parameters", "seconds", "peak MiB", "arena allocs", "heap", "stages");
+
+        Replay replay;
+        double replayed = 0.0;
+        for (std::size_t i = 0; i < actions.size(); ++i) {
+            const auto& action = actions[i];
+            {
+                // the peak of the compute calls of the operation, they nest in this scope
+                MemoryScope scope("replay");
+                replay.run(action);
+            }
+            double seconds = 0.0;
+            std::string stages;
+            for (const auto& [stage, stageSeconds] : replay.stages()) {
+                seconds += stageSeconds;
+                stages += std::format("{} {:.3f}s ", stage, stageSeconds);
+            }
+            replayed += seconds;
+            auto memory = lastOperationMemory();
+            std::cout << std::format("{:>4}  {:<10} {:<44} {:>10.3f} {:>10.1f} {:>12} {:>6}  {}\n", i + 1,
+                                     typeName(action.type), parameters(action), seconds, toMiB(memory.peakBytes),
+                                     memory.arena.allocations, memory.arena.heapBlocks, stages);
+        }
+
+        double recorded = actions.empty() ? 0.0 : actions.back().time - actions.front().time;
+        std::cout << std::format("\nrecorded session {:.3f} s, replayed operations {:.3f} s\n", recorded, replayed);
+        for (const auto& [stage, total] : replay.totals()) {
+            double share = replayed > 0.0 ? 100.0 * total.seconds / replayed : 0.0;
+            std::cout << std::format("{:<10} {:>4} x {:>10.3f} s {:>6.1f}%\n", stage, total.count, total.seconds,
+                                     share);
+        }
+    } catch (const std::exception& e) {
+        std::cerr << std::format("Error: {}\n", e.what());
+        return 1;
+    }
+    return 0;
+}